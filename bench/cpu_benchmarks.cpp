@@ -0,0 +1,425 @@
+﻿#include "../headers/obj_loader.h"
+#include "../headers/body_simulation.h"
+#include "../headers/view.h"
+#include "../headers/camera.h"
+#include "../headers/meshlet.h"
+#include "../headers/spatial_hash.h"
+
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// --- Синтетические данные ---
+
+// Радиус сетки тела: с ним при камере из makeViews часть тел крупнее порога импосторов
+const float BENCH_MESH_RADIUS = 10.0f;
+
+/**
+ * @brief OBJ с сеткой side x side квадратов, из которых берутся первые faceCount треугольников.
+ * * Формат граней - v/vt, как у моделей лабораторной.
+ */
+static std::string generateObj(size_t faceCount) {
+    size_t side = static_cast<size_t>(std::ceil(std::sqrt(faceCount / 2.0)));
+    if (side == 0)
+        side = 1;
+
+    std::string text;
+    text.reserve(faceCount * 40 + (side + 1) * (side + 1) * 48);
+    char line[128];
+
+    for (size_t y = 0; y <= side; ++y) {
+        for (size_t x = 0; x <= side; ++x) {
+            float u = static_cast<float>(x) / side;
+            float v = static_cast<float>(y) / side;
+            std::snprintf(line, sizeof(line), "v %.6f %.6f 0.0\nvt %.6f %.6f\n", u * 2.0f - 1.0f, v * 2.0f - 1.0f, u, v);
+            text += line;
+        }
+    }
+
+    size_t emitted = 0;
+    for (size_t y = 0; y < side && emitted < faceCount; ++y) {
+        for (size_t x = 0; x < side && emitted < faceCount; ++x) {
+            // Индексы OBJ начинаются с 1
+            size_t i0 = y * (side + 1) + x + 1;
+            size_t i1 = i0 + 1;
+            size_t i2 = i0 + side + 1;
+            size_t i3 = i2 + 1;
+            std::snprintf(line, sizeof(line), "f %zu/%zu %zu/%zu %zu/%zu\n", i0, i0, i1, i1, i3, i3);
+            text += line;
+            if (++emitted < faceCount) {
+                std::snprintf(line, sizeof(line), "f %zu/%zu %zu/%zu %zu/%zu\n", i0, i0, i3, i3, i2, i2);
+                text += line;
+                ++emitted;
+            }
+        }
+    }
+    return text;
+}
+
+// Один текст на размер: генерация 10M граней дороже самого разбора
+static const std::string& cachedObj(size_t faceCount) {
+    static std::map<size_t, std::string> cache;
+    auto it = cache.find(faceCount);
+    if (it == cache.end())
+        it = cache.emplace(faceCount, generateObj(faceCount)).first;
+    return it->second;
+}
+
+/**
+ * @brief Замкнутая UV-сфера радиуса radius развёрнутым списком треугольников (как Model::getVertices).
+ * * Позиции на шве и полюсах совпадают точно, как у сетки с общими вершинами в OBJ.
+ */
+static std::vector<Vertex> generateSphere(int segments, float radius) {
+    int stacks = segments;
+    int slices = segments * 2;
+    auto vertexAt = [&](int i, int j) {
+        const float pi = 3.14159265358979f;
+        float theta = pi * i / stacks;
+        float phi = 2.0f * pi * (j % slices) / slices;
+        Vertex v;
+        if (i == 0 || i == stacks)
+            v.Position = glm::vec3(0.0f, i == 0 ? radius : -radius, 0.0f);
+        else
+            v.Position = radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), -std::sin(theta) * std::sin(phi));
+        v.TexCoords = glm::vec2(static_cast<float>(j) / slices, 1.0f - static_cast<float>(i) / stacks);
+        return v;
+    };
+
+    std::vector<Vertex> vertices;
+    vertices.reserve(static_cast<size_t>(stacks) * slices * 6);
+    for (int i = 0; i < stacks; ++i) {
+        for (int j = 0; j < slices; ++j) {
+            // Обход против часовой стрелки при взгляде снаружи
+            Vertex a = vertexAt(i, j), b = vertexAt(i + 1, j), c = vertexAt(i + 1, j + 1), d = vertexAt(i, j + 1);
+            vertices.push_back(a); vertices.push_back(b); vertices.push_back(c);
+            vertices.push_back(a); vertices.push_back(c); vertices.push_back(d);
+        }
+    }
+    return vertices;
+}
+
+/**
+ * @brief Тела на круговых орбитах с разбросом радиусов, скоростей и масштабов (как кольцо в сцене).
+ */
+static std::vector<CelestialBody> generateBodies(size_t count) {
+    std::mt19937 rng(12345u);
+    std::uniform_real_distribution<float> radius(10.0f, 400.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    std::uniform_real_distribution<float> speed(1.0f, 40.0f);
+    std::uniform_real_distribution<float> scale(0.05f, 1.0f);
+
+    std::vector<CelestialBody> bodies(count);
+    for (CelestialBody& body : bodies) {
+        body.Position = glm::vec3(0.0f);
+        body.OrbitRadius = radius(rng);
+        body.OrbitSpeed = speed(rng);
+        body.RotationSpeed = speed(rng);
+        body.Scale = scale(rng);
+        body.OrbitAngle = angle(rng);
+        body.RotationAngle = 0.0f;
+        body.TextureIndex = 0;
+    }
+    return bodies;
+}
+
+// Камера как в main.cpp: 1280x720, один вид или четыре четверти окна
+static std::vector<View> makeViews(int viewCount) {
+    Camera camera(glm::vec3(0.0f, 50.0f, 300.0f));
+    float fovY = glm::radians(camera.Zoom);
+    glm::mat4 viewMatrix = glm::lookAt(camera.Position, camera.Position + camera.Front, camera.Up);
+
+    std::vector<View> views;
+    if (viewCount == 1) {
+        views.push_back(buildView(viewMatrix, camera.Position, fovY, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), 1280, 720));
+        return views;
+    }
+    const glm::vec4 rects[4] = {
+        glm::vec4(-0.5f, 0.5f, 0.5f, 0.5f), glm::vec4(0.5f, 0.5f, 0.5f, 0.5f),
+        glm::vec4(-0.5f, -0.5f, 0.5f, 0.5f), glm::vec4(0.5f, -0.5f, 0.5f, 0.5f)
+    };
+    const glm::vec3 eyes[4] = {
+        camera.Position, glm::vec3(0.0f, 200.0f, 0.0f), glm::vec3(200.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 200.0f)
+    };
+    for (int i = 0; i < viewCount && i < 4; ++i) {
+        glm::mat4 view = i == 0 ? viewMatrix
+            : glm::lookAt(eyes[i], glm::vec3(0.0f), i == 1 ? glm::vec3(0.0f, 0.0f, -1.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+        views.push_back(buildView(view, eyes[i], fovY, rects[i], 1280, 720));
+    }
+    return views;
+}
+
+// --- Загрузчик ---
+
+static void BM_ParseObj(benchmark::State& state) {
+    size_t faceCount = static_cast<size_t>(state.range(0));
+    const std::string& text = cachedObj(faceCount);
+    std::vector<Vertex> vertices;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::istringstream stream(text);
+        vertices.clear();
+        state.ResumeTiming();
+
+        bool ok = parseObj(stream, vertices, "synthetic");
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(vertices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(faceCount));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_ParseObj)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+
+// Как Model::loadModel: чтение файла и разбор
+static void BM_LoadObjFile(benchmark::State& state) {
+    size_t faceCount = static_cast<size_t>(state.range(0));
+    std::string path = "bench_" + std::to_string(faceCount) + ".obj";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << cachedObj(faceCount);
+    }
+    std::vector<Vertex> vertices;
+
+    for (auto _ : state) {
+        vertices.clear();
+        bool ok = loadObj(path, vertices);
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(vertices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(faceCount));
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_LoadObjFile)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+
+// --- Движение тел (SolarSystem::update без BVH) ---
+
+static void BM_UpdateBodies(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    std::vector<CelestialBody> bodies = generateBodies(count);
+    std::vector<glm::mat4> matrices(count);
+    std::vector<BoundingSphere> bounds(count);
+
+    for (auto _ : state) {
+        advanceBodies(bodies.data(), count, 1.0f / 60.0f, matrices.data());
+        computeBodyBounds(bodies.data(), count, BENCH_MESH_RADIUS, bounds.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_UpdateBodies)->RangeMultiplier(10)->Range(10, 10000000);
+
+// --- Упаковка видимых экземпляров (SolarSystem::draw до вызовов OpenGL) ---
+
+static void BM_PackInstances(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    int viewCount = static_cast<int>(state.range(1));
+    std::vector<CelestialBody> bodies = generateBodies(count);
+    std::vector<glm::mat4> matrices(count);
+    std::vector<BoundingSphere> bounds(count);
+    advanceBodies(bodies.data(), count, 0.0f, matrices.data());
+    computeBodyBounds(bodies.data(), count, BENCH_MESH_RADIUS, bounds.data());
+    std::vector<View> views = makeViews(viewCount);
+
+    std::vector<glm::mat4> meshInstances;
+    std::vector<glm::mat4> impostorInstances;
+    for (auto _ : state) {
+        size_t blended = packInstances(views.data(), static_cast<int>(views.size()), bounds.data(), matrices.data(),
+            count, true, meshInstances, impostorInstances);
+        benchmark::DoNotOptimize(blended);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    state.counters["mesh"] = static_cast<double>(meshInstances.size());
+    state.counters["impostor"] = static_cast<double>(impostorInstances.size());
+}
+BENCHMARK(BM_PackInstances)->ArgsProduct({ benchmark::CreateRange(10, 10000000, 10), { 1, 4 } });
+
+// --- Кластеры сетки ---
+
+static void BM_BuildMeshlets(benchmark::State& state) {
+    std::vector<Vertex> vertices = generateSphere(static_cast<int>(state.range(0)), BENCH_MESH_RADIUS);
+    MeshletMesh mesh;
+    for (auto _ : state) {
+        bool ok = mesh.build(vertices);
+        benchmark::DoNotOptimize(ok);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(vertices.size() / 3));
+    state.counters["meshlets"] = static_cast<double>(mesh.getMeshlets().size());
+    state.counters["cone_culling"] = mesh.isConeCullingAllowed() ? 1.0 : 0.0;
+}
+BENCHMARK(BM_BuildMeshlets)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+
+// Отсечение кластеров видимых экземпляров, как в SolarSystem::draw
+static void BM_CullMeshlets(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    int viewCount = static_cast<int>(state.range(1));
+    MeshletMesh mesh;
+    mesh.build(generateSphere(64, BENCH_MESH_RADIUS));
+
+    std::vector<CelestialBody> bodies = generateBodies(count);
+    std::vector<glm::mat4> matrices(count);
+    std::vector<BoundingSphere> bounds(count);
+    advanceBodies(bodies.data(), count, 0.0f, matrices.data());
+    computeBodyBounds(bodies.data(), count, BENCH_MESH_RADIUS, bounds.data());
+    std::vector<View> views = makeViews(viewCount);
+
+    std::vector<glm::mat4> meshInstances;
+    std::vector<glm::mat4> impostorInstances;
+    packInstances(views.data(), viewCount, bounds.data(), matrices.data(), count, false, meshInstances, impostorInstances);
+
+    std::vector<DrawElementsIndirectCommand> commands;
+    MeshletCullStats stats = MeshletCullStats();
+    for (auto _ : state) {
+        ++stats.Frames;
+        cullMeshlets(mesh, views.data(), viewCount, meshInstances.data(), meshInstances.size(), commands, stats);
+        benchmark::DoNotOptimize(commands.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(meshInstances.size() * mesh.getMeshlets().size()));
+    double triangles = static_cast<double>(std::max<size_t>(stats.Triangles, 1));
+    state.counters["instances"] = static_cast<double>(meshInstances.size());
+    state.counters["frustum_culled"] = stats.FrustumCulled / triangles;
+    state.counters["cone_culled"] = stats.ConeCulled / triangles;
+    state.counters["commands"] = static_cast<double>(commands.size());
+}
+BENCHMARK(BM_CullMeshlets)->ArgsProduct({ benchmark::CreateRange(1000, 100000, 10), { 1, 4 } })->Unit(benchmark::kMillisecond);
+
+// --- Поиск сближений ---
+
+// До этого числа тел результат хеша сверяется с полным перебором (16384 - размер из ряда с шагом 4)
+const size_t BENCH_BRUTE_FORCE_MAX = 16384;
+
+/**
+ * @brief Сферы тел для поиска сближений: радиус сетки уменьшается с ростом числа тел,
+ * * чтобы у тела в среднем был примерно один сосед на расстоянии радиуса при любом count.
+ */
+static std::vector<BoundingSphere> generateProximityBounds(size_t count, float& meshRadius) {
+    meshRadius = 50.0f / std::sqrt(static_cast<float>(count));
+    std::vector<CelestialBody> bodies = generateBodies(count);
+    std::vector<glm::mat4> matrices(count);
+    std::vector<BoundingSphere> bounds(count);
+    advanceBodies(bodies.data(), count, 0.0f, matrices.data());
+    computeBodyBounds(bodies.data(), count, meshRadius, bounds.data());
+    return bounds;
+}
+
+static bool samePairs(std::vector<ProximityPair> a, std::vector<ProximityPair> b) {
+    auto byBodies = [](const ProximityPair& x, const ProximityPair& y) { return x.A != y.A ? x.A < y.A : x.B < y.B; };
+    std::sort(a.begin(), a.end(), byBodies);
+    std::sort(b.begin(), b.end(), byBodies);
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].A != b[i].A || a[i].B != b[i].B)
+            return false;
+    }
+    return true;
+}
+
+// Перестройка после каждого update, как в SolarSystem; второй аргумент - число потоков (0 - по числу ядер)
+static void BM_SpatialHashBuild(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    unsigned threads = static_cast<unsigned>(state.range(1));
+    float meshRadius;
+    std::vector<BoundingSphere> bounds = generateProximityBounds(count, meshRadius);
+    SpatialHash hash;
+    for (auto _ : state) {
+        hash.build(bounds.data(), count, meshRadius, threads);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_SpatialHashBuild)->ArgsProduct({ benchmark::CreateRange(1000, 1000000, 10), { 1, 0 } })
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Перестройка и все пары ближе радиуса сетки; до 16k тел результат сверяется с перебором
+static void BM_SpatialHashPairs(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    float meshRadius;
+    std::vector<BoundingSphere> bounds = generateProximityBounds(count, meshRadius);
+    SpatialHash hash;
+    std::vector<ProximityPair> pairs;
+
+    if (count <= BENCH_BRUTE_FORCE_MAX) {
+        std::vector<ProximityPair> reference;
+        hash.build(bounds.data(), count, meshRadius);
+        hash.pairsCloserThan(meshRadius, pairs);
+        bruteForcePairs(bounds.data(), count, meshRadius, reference);
+        if (!samePairs(pairs, reference)) {
+            state.SkipWithError("spatial hash pairs differ from brute force");
+            return;
+        }
+    }
+
+    for (auto _ : state) {
+        hash.build(bounds.data(), count, meshRadius);
+        hash.pairsCloserThan(meshRadius, pairs);
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    state.counters["pairs"] = static_cast<double>(pairs.size());
+}
+BENCHMARK(BM_SpatialHashPairs)->RangeMultiplier(4)->Range(1000, 1024000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_BruteForcePairs(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    float meshRadius;
+    std::vector<BoundingSphere> bounds = generateProximityBounds(count, meshRadius);
+    std::vector<ProximityPair> pairs;
+    for (auto _ : state) {
+        bruteForcePairs(bounds.data(), count, meshRadius, pairs);
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    state.counters["pairs"] = static_cast<double>(pairs.size());
+}
+BENCHMARK(BM_BruteForcePairs)->RangeMultiplier(4)->Range(1000, BENCH_BRUTE_FORCE_MAX)->Unit(benchmark::kMillisecond);
+
+static void BM_SpatialHashNeighbors(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+    float meshRadius;
+    std::vector<BoundingSphere> bounds = generateProximityBounds(count, meshRadius);
+    SpatialHash hash;
+    hash.build(bounds.data(), count, meshRadius);
+    std::vector<ProximityPair> neighbors;
+    size_t body = 0;
+    for (auto _ : state) {
+        hash.neighbors(body, meshRadius, neighbors);
+        benchmark::DoNotOptimize(neighbors.data());
+        body = (body + 7919) % count;
+    }
+}
+BENCHMARK(BM_SpatialHashNeighbors)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// --- Камера ---
+
+static void BM_CameraMouseMovement(benchmark::State& state) {
+    Camera camera(glm::vec3(0.0f, 0.0f, 150.0f));
+    float offset = 1.0f;
+    for (auto _ : state) {
+        // Поворот туда и обратно, чтобы тангаж не упирался в ограничение
+        camera.processMouseMovement(offset, offset);
+        offset = -offset;
+        benchmark::DoNotOptimize(camera.Front);
+    }
+}
+BENCHMARK(BM_CameraMouseMovement);
+
+static void BM_CameraViewMatrix(benchmark::State& state) {
+    Camera camera(glm::vec3(0.0f, 0.0f, 150.0f));
+    for (auto _ : state) {
+        glm::mat4 view = camera.getViewMatrix();
+        benchmark::DoNotOptimize(view);
+    }
+}
+BENCHMARK(BM_CameraViewMatrix);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include "../headers/scene.h"
+#include "../headers/bvh.h"
+#include "../headers/view.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+// Экранный диаметр (в пикселях), ниже которого тело рисуется только импостором,
+// и выше которого - только сеткой; между ними - плавный переход
+const float IMPOSTOR_SCREEN_SIZE = 32.0f;
+const float IMPOSTOR_BLEND_SIZE = 48.0f;
+
+/**
+ * Покадровая работа CPU над телами без обращений к OpenGL:
+ * движение по орбитам, построение матриц, ограничивающие сферы и упаковка
+ * видимых экземпляров. SolarSystem вызывает эти функции каждый кадр,
+ * бенчмарки (bench/) - без контекста OpenGL.
+ */
+
+/**
+ * @brief Поворачивает Солнце на deltaTime и возвращает его матрицу модели.
+ */
+glm::mat4 advanceSun(CelestialBody& sun, float deltaTime);
+
+/**
+ * @brief Продвигает тела по орбитам и вращение вокруг оси на deltaTime
+ * * и записывает матрицы модели в matrices[0..count).
+ */
+void advanceBodies(CelestialBody* bodies, size_t count, float deltaTime, glm::mat4* matrices);
+
+/**
+ * @brief Ограничивающие сферы тел: радиус сетки, умноженный на масштаб тела.
+ */
+void computeBodyBounds(const CelestialBody* bodies, size_t count, float meshRadius, BoundingSphere* bounds);
+
+/**
+ * @brief Отбирает тела, видимые хотя бы в одном виде, и раскладывает их матрицы по проходам.
+ * * При useImpostors тела меньше IMPOSTOR_BLEND_SIZE пикселей попадают в impostorInstances,
+ * * в полосе перехода - в оба списка; доля импостора записывается в элемент [0][3]
+ * * матрицы (у аффинной матрицы он всегда 0).
+ * @return Число тел в полосе перехода (попавших в оба списка).
+ */
+size_t packInstances(const View* views, int viewCount, const BoundingSphere* bounds, const glm::mat4* matrices,
+    size_t count, bool useImpostors, std::vector<glm::mat4>& meshInstances, std::vector<glm::mat4>& impostorInstances);
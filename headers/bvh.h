@@ -0,0 +1,170 @@
+﻿#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+struct Ray {
+    glm::vec3 Origin;
+    glm::vec3 Direction;
+};
+
+struct BoundingSphere {
+    glm::vec3 Center;
+    float Radius;
+};
+
+struct AABB {
+    glm::vec3 Min;
+    glm::vec3 Max;
+};
+
+/**
+ * @brief Узел BVH. Для листа Count > 0 и First указывает на первый примитив,
+ * * для внутреннего узла Count == 0 и First — индекс левого потомка (правый идёт следом).
+ * * Потомки всегда хранятся после родителя, поэтому refit — один обратный проход по массиву.
+ */
+struct BVHNode {
+    AABB Bounds;
+    uint32_t First;
+    uint32_t Count;
+};
+
+/**
+ * @brief BVH по ограничивающим сферам экземпляров с поддержкой refit.
+ * * Структура дерева строится один раз, а каждый кадр только пересчитываются рамки
+ * * узлов. Если после refit дерево заметно деградировало (тела разъехались по орбитам),
+ * * оно перестраивается.
+ */
+class InstanceBVH {
+public:
+    InstanceBVH();
+
+    /**
+     * @brief Обновляет дерево: refit, если число сфер не изменилось, иначе полная перестройка.
+     */
+    void update(const std::vector<BoundingSphere>& spheres);
+
+    void build(const std::vector<BoundingSphere>& spheres);
+
+    /**
+     * @brief Пересчитывает рамки узлов без изменения топологии.
+     * @return false, если дерево деградировало и его стоит перестроить.
+     */
+    bool refit(const std::vector<BoundingSphere>& spheres);
+
+    /**
+     * @brief Ищет ближайшее попадание луча. Для каждой сферы, пересечённой ближе текущего
+     * * лучшего результата, вызывается exactTest(index, t), который может уточнить t
+     * * (например, пересечением с треугольниками) и вернуть false при промахе.
+     * @return Индекс экземпляра или -1.
+     */
+    template <typename ExactTest>
+    int64_t intersect(const Ray& ray, float& tHit, ExactTest exactTest) const;
+
+    size_t getPrimitiveCount() const { return m_indices.size(); }
+    size_t getNodeCount() const { return m_nodes.size(); }
+
+private:
+    std::vector<BVHNode> m_nodes;
+    std::vector<uint32_t> m_indices;
+    const BoundingSphere* m_spheres;
+    float m_builtCost;
+
+    float computeCost() const;
+};
+
+/**
+ * @brief Статическая BVH по треугольникам сетки в пространстве модели.
+ */
+class TriangleBVH {
+public:
+    /**
+     * @param positions Вершины треугольников подряд, по три на треугольник.
+     */
+    void build(const std::vector<glm::vec3>& positions);
+
+    /**
+     * @brief Ближайшее пересечение луча с треугольниками (луч в пространстве модели).
+     * @param tHit На входе — максимальное расстояние, на выходе — расстояние до попадания.
+     */
+    bool intersect(const Ray& ray, float& tHit) const;
+
+    size_t getTriangleCount() const { return m_triangles.size(); }
+
+private:
+    struct Triangle {
+        glm::vec3 V0;
+        glm::vec3 Edge1;
+        glm::vec3 Edge2;
+    };
+
+    std::vector<BVHNode> m_nodes;
+    std::vector<Triangle> m_triangles;
+};
+
+// --- Вспомогательные тесты пересечения ---
+
+bool intersectRayAABB(const Ray& ray, const glm::vec3& invDir, const AABB& box, float tMax, float& tEnter);
+bool intersectRaySphere(const Ray& ray, const BoundingSphere& sphere, float& tEnter);
+
+template <typename ExactTest>
+int64_t InstanceBVH::intersect(const Ray& ray, float& tHit, ExactTest exactTest) const {
+    if (m_nodes.empty()) {
+        return -1;
+    }
+
+    glm::vec3 invDir(1.0f / ray.Direction.x, 1.0f / ray.Direction.y, 1.0f / ray.Direction.z);
+    int64_t best = -1;
+
+    uint32_t stack[64];
+    int stackSize = 0;
+    float tEnter;
+    if (!intersectRayAABB(ray, invDir, m_nodes[0].Bounds, tHit, tEnter)) {
+        return -1;
+    }
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const BVHNode& node = m_nodes[stack[--stackSize]];
+
+        if (node.Count > 0) {
+            for (uint32_t i = node.First; i < node.First + node.Count; ++i) {
+                uint32_t index = m_indices[i];
+                float tSphere;
+                if (!intersectRaySphere(ray, m_spheres[index], tSphere) || tSphere > tHit) {
+                    continue;
+                }
+                float t = tHit;
+                if (exactTest(index, t) && t < tHit) {
+                    tHit = t;
+                    best = index;
+                }
+            }
+            continue;
+        }
+
+        // Сначала обходим ближний потомок: он кладётся в стек последним
+        float tLeft, tRight;
+        bool hitLeft = intersectRayAABB(ray, invDir, m_nodes[node.First].Bounds, tHit, tLeft);
+        bool hitRight = intersectRayAABB(ray, invDir, m_nodes[node.First + 1].Bounds, tHit, tRight);
+        if (hitLeft && hitRight) {
+            if (tLeft < tRight) {
+                stack[stackSize++] = node.First + 1;
+                stack[stackSize++] = node.First;
+            }
+            else {
+                stack[stackSize++] = node.First;
+                stack[stackSize++] = node.First + 1;
+            }
+        }
+        else if (hitLeft) {
+            stack[stackSize++] = node.First;
+        }
+        else if (hitRight) {
+            stack[stackSize++] = node.First + 1;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include "../headers/shader.h"
+#include "../headers/gpu_timer.h"
+
+#include <GL/glew.h>
+
+enum Upscale_Filter {
+    UPSCALE_BILINEAR,
+    UPSCALE_SHARPEN  // Билинейное увеличение и нерезкое маскирование по соседним текселям
+};
+
+/**
+ * @brief Динамическое разрешение рендеринга под бюджет времени GPU.
+ * * Сцена рисуется в промежуточный буфер кадра размером с окно, но только в его
+ * * левый нижний прямоугольник размером scale * окно, поэтому смена масштаба не
+ * * требует перевыделения. Время GPU на сцену замеряется метками времени; по готовым
+ * * результатам регулятор подбирает масштаб так, чтобы время было в пределах бюджета
+ * * (время считается пропорциональным числу пикселей, то есть квадрату масштаба).
+ * * Затем изображение растягивается на окно полноэкранным проходом.
+ */
+class DynamicResolution {
+public:
+    /**
+     * @param gpuBudgetMs Целевое время GPU на сцену в миллисекундах.
+     * @param minScale, maxScale Пределы масштаба по каждой оси.
+     */
+    DynamicResolution(float gpuBudgetMs, float minScale = 0.5f, float maxScale = 1.0f);
+    ~DynamicResolution();
+
+    // Перевыделяет промежуточный буфер под новый размер окна
+    void resize(int windowWidth, int windowHeight);
+
+    /**
+     * @brief Привязывает буфер кадра для сцены и начинает замер.
+     * * Сцену рисовать в прямоугольник (0, 0, getRenderWidth(), getRenderHeight()).
+     */
+    void beginFrame();
+
+    /**
+     * @brief Заканчивает замер, растягивает изображение на окно и обновляет масштаб.
+     */
+    void endFrame();
+
+    // Выключено - сцена рисуется прямо в окно с масштабом 1
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+
+    void setFilter(Upscale_Filter filter) { m_filter = filter; }
+    Upscale_Filter getFilter() const { return m_filter; }
+
+    // Без промежуточного буфера (выключено или не удалось выделить) масштаб всегда 1
+    float getScale() const { return m_enabled && m_framebuffer != 0 ? m_scale : 1.0f; }
+    int getRenderWidth() const;
+    int getRenderHeight() const;
+    double getLastGpuMs() const { return m_timer.getLastMs(); }
+    float getBudgetMs() const { return m_budgetMs; }
+
+private:
+    float m_budgetMs;
+    float m_minScale;
+    float m_maxScale;
+    float m_scale;
+    bool m_enabled;
+    Upscale_Filter m_filter;
+
+    int m_windowWidth;
+    int m_windowHeight;
+    GLuint m_framebuffer;
+    GLuint m_colorTexture;
+    GLuint m_depthRenderbuffer;
+    GLuint m_emptyVAO; // Полноэкранный треугольник строится из gl_VertexID
+
+    Shader m_upscaleShader;
+    GpuTimer m_timer;
+
+    void release();
+    void updateScale();
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+};
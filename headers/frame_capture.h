@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+enum Capture_Format {
+    CAPTURE_Y4M, // Один файл .y4m (YUV 4:2:0)
+    CAPTURE_PPM  // Последовательность файлов <имя>_000000.ppm
+};
+
+/**
+ * @brief Запись кадров на диск без остановки конвейера GPU.
+ * * Каждый кадр читается glReadPixels в один из кольца pixel-pack буферов (PBO),
+ * * после чего ставится fence. Буфер отображается в память только когда его fence
+ * * уже сработал (через несколько кадров), а пиксели передаются потоку записи.
+ * * Если поток записи не успевает, кадр пропускается, а не тормозит рендеринг.
+ */
+class FrameCapture {
+public:
+    /**
+     * @param width, height Размер захватываемой области (обычно размер окна).
+     * @param outputPath Путь к .y4m файлу или префикс для .ppm последовательности.
+     * @param format Формат вывода.
+     * @param fps Частота кадров, записываемая в заголовок Y4M.
+     * @param ringSize Количество PBO в кольце (задержка чтения в кадрах).
+     */
+    FrameCapture(GLuint width, GLuint height, const std::string& outputPath, Capture_Format format, int fps = 60, int ringSize = 4);
+
+    /**
+     * @brief Дочитывает кадры в полёте и дожидается потока записи.
+     */
+    ~FrameCapture();
+
+    /**
+     * @brief Ставит в очередь чтение текущего back buffer. Вызывать перед window.display().
+     */
+    void captureFrame();
+
+    uint64_t getCapturedFrames() const { return m_capturedFrames; }
+    uint64_t getDroppedFrames() const { return m_droppedFrames; }
+    uint64_t getWrittenFrames() const { return m_writtenFrames.load(); }
+
+private:
+    struct Slot {
+        GLuint pbo;
+        GLsync fence;
+        uint64_t frameIndex;
+    };
+
+    struct Frame {
+        std::vector<unsigned char> pixels; // RGBA, строки снизу вверх (как в OpenGL)
+        uint64_t frameIndex;
+    };
+
+    GLuint m_width;
+    GLuint m_height;
+    std::string m_outputPath;
+    Capture_Format m_format;
+    int m_fps;
+
+    std::vector<Slot> m_slots;
+    size_t m_head;     // Слот для следующего glReadPixels
+    size_t m_inFlight; // Количество слотов, ожидающих свой fence
+
+    uint64_t m_capturedFrames;
+    uint64_t m_droppedFrames;
+    std::atomic<uint64_t> m_writtenFrames;
+
+    // Очередь к потоку записи и пул кадров для повторного использования памяти
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_queueChanged;
+    std::deque<Frame*> m_queue;
+    std::vector<Frame*> m_freeFrames;
+    size_t m_allocatedFrames;
+    bool m_stopping;
+
+    std::ofstream m_y4mFile;
+
+    bool retireSlot(Slot& slot, bool wait);
+    Frame* acquireFrame();
+    void releaseFrame(Frame* frame);
+
+    void writerLoop();
+    void writeY4MFrame(const Frame& frame, std::vector<unsigned char>& yuv);
+    void writePPMFrame(const Frame& frame, std::vector<unsigned char>& rgb);
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+};
@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief Точное ограничение частоты кадров и замер задержки ввода.
+ * * Вместо sf::Window::setFramerateLimit (который просто спит с грубой точностью)
+ * * кадры выстраиваются по сетке с шагом targetFrameTime. Ожидание гибридное:
+ * * основная часть интервала — sleep, последние spinThreshold миллисекунд —
+ * * активное ожидание, поэтому начало кадра не "дрожит" на величину кванта планировщика.
+ */
+class FramePacer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Stats {
+        uint64_t Frames;
+        double MeanFrameMs;     // Среднее время между представлениями кадров
+        double FrameStdDevMs;   // Стандартное отклонение времени кадра
+        double MaxFrameMs;
+        double MeanLatencyMs;   // Среднее время от опроса ввода до window.display()
+        double MaxLatencyMs;
+    };
+
+    /**
+     * @param targetFps Целевая частота кадров.
+     * @param spinThresholdMs Сколько миллисекунд до дедлайна ждать активно, а не во сне.
+     */
+    FramePacer(float targetFps = 60.0f, float spinThresholdMs = 2.0f);
+
+    ~FramePacer();
+
+    /**
+     * @brief Ждёт начала следующего кадра.
+     * @return deltaTime — время с начала предыдущего кадра в секундах.
+     */
+    float waitForNextFrame();
+
+    // Отмечает момент опроса ввода (непосредственно перед Camera::getViewMatrix)
+    void markInputSampled();
+
+    // Отмечает момент представления кадра (сразу после window.display())
+    void markPresented();
+
+    Stats getStats() const;
+    void resetStats();
+
+    /**
+     * @brief Раз в intervalSeconds печатает статистику и сбрасывает её.
+     */
+    void reportEvery(float intervalSeconds, std::ostream& out);
+
+private:
+    Clock::duration m_targetFrameTime;
+    Clock::duration m_spinThreshold;
+
+    Clock::time_point m_nextFrame;
+    Clock::time_point m_lastFrameStart;
+    Clock::time_point m_inputSampled;
+    Clock::time_point m_lastPresent;
+    Clock::time_point m_lastReport;
+    bool m_hasPresent;
+
+    // Накопители статистики (алгоритм Уэлфорда для дисперсии)
+    uint64_t m_frames;
+    double m_frameMean;
+    double m_frameM2;
+    double m_frameMax;
+    uint64_t m_latencySamples;
+    double m_latencySum;
+    double m_latencyMax;
+};
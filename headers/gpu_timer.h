@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+
+/**
+ * @brief Замер времени GPU парой меток GL_TIMESTAMP без ожидания результата.
+ * * Пары запросов берутся из кольца: результат кадра забирается через несколько кадров,
+ * * когда он уже готов, поэтому CPU не ждёт GPU. Если все пары кольца ещё
+ * * в работе, замер пропускается.
+ * * В отличие от GL_TIME_ELAPSED, метки времени не мешают друг другу,
+ * * поэтому замеры разных таймеров могут вкладываться.
+ */
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    void begin();
+    void end();
+
+    /**
+     * @brief Забирает готовые результаты.
+     * @param wait Ждать результаты всех запросов (только для завершения замеров).
+     * @return true, если появился хотя бы один новый результат.
+     */
+    bool poll(bool wait = false);
+
+    double getLastMs() const { return m_lastMs; }
+    double getAverageMs() const { return m_samples > 0 ? m_totalMs / m_samples : 0.0; }
+    size_t getSampleCount() const { return m_samples; }
+
+    // Сбрасывает накопленные результаты; запросы в работе отбрасываются
+    void reset();
+
+private:
+    static const int RING_SIZE = 4;
+
+    GLuint m_queries[RING_SIZE][2]; // Метки начала и конца
+    bool m_pending[RING_SIZE];
+    int m_next;     // Следующий запрос для begin(), он же самый старый в работе
+    bool m_active;  // begin() занял запрос и ждёт end()
+    int m_discard;  // Сколько результатов отбросить после reset()
+
+    double m_lastMs;
+    double m_totalMs;
+    size_t m_samples;
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+};
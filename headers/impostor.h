@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include "../headers/shader.h"
+#include "../headers/model.h"
+#include "../headers/texture.h"
+#include "../headers/multi_view.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+const int IMPOSTOR_FRAMES_PER_SIDE = 8;  // Сетка ракурсов атласа: 8 x 8
+const int IMPOSTOR_FRAME_SIZE = 64;      // Размер одного ракурса в пикселях
+
+/**
+ * @brief Октаэдрический атлас ракурсов сетки: цвет и глубина.
+ * * Направления на наблюдателя (в пространстве модели) отображаются на квадрат
+ * * октаэдрической развёрткой; квадрат делится на framesPerSide x framesPerSide ячеек,
+ * * и для направления в центре каждой ячейки сетка рисуется ортографической камерой,
+ * * охватывающей ограничивающую сферу. Глубина линейна в пределах [-R, R] от центра.
+ */
+class ImpostorAtlas {
+public:
+    ImpostorAtlas();
+    ~ImpostorAtlas();
+
+    /**
+     * @brief Запекает атлас сетки model с текстурой texture.
+     * * Рисует основным шейдером сцены; состояние viewport и framebuffer восстанавливается.
+     * @return false, если framebuffer не удалось собрать.
+     */
+    bool bake(Shader& shader, Model& model, Texture* texture,
+        int framesPerSide = IMPOSTOR_FRAMES_PER_SIDE, int frameSize = IMPOSTOR_FRAME_SIZE);
+
+    // Цвет - в colorUnit, глубина - в depthUnit
+    void bind(GLuint colorUnit, GLuint depthUnit) const;
+
+    bool isBaked() const { return m_colorTexture != 0; }
+    int getFramesPerSide() const { return m_framesPerSide; }
+    float getBoundingRadius() const { return m_boundingRadius; }
+
+    /**
+     * @brief Направление ячейки атласа: uv в [-1, 1], как в вершинном шейдере импосторов.
+     */
+    static glm::vec3 octahedralDecode(const glm::vec2& uv);
+
+private:
+    GLuint m_colorTexture;
+    GLuint m_depthTexture;
+    int m_framesPerSide;
+    int m_atlasSize;
+    float m_boundingRadius;
+
+    void release();
+
+    ImpostorAtlas(const ImpostorAtlas&) = delete;
+    ImpostorAtlas& operator=(const ImpostorAtlas&) = delete;
+};
+
+/**
+ * @brief Рисует экземпляры как квадраты, обращённые к наблюдателю и текстурированные атласом.
+ * * Все импосторы рисуются одним экземплярным вызовом (во все виды MultiView сразу).
+ * * Для каждого экземпляра вершинный шейдер выбирает ячейку атласа по направлению
+ * * на наблюдателя в пространстве модели и ставит квадрат в плоскость её камеры;
+ * * фрагментный шейдер восстанавливает глубину из атласа, поэтому импосторы
+ * * корректно пересекаются с сетками.
+ * * Матрицы экземпляров - как у Model; в элементе [0][3] передаётся доля импостора
+ * * при плавном переходе (фрагменты отбрасываются упорядоченным дизерингом).
+ */
+class ImpostorRenderer {
+public:
+    ImpostorRenderer();
+    ~ImpostorRenderer();
+
+    void draw(const MultiView& views, const ImpostorAtlas& atlas, const std::vector<glm::mat4>& instances);
+
+private:
+    Shader m_shader;
+    GLuint m_quadVAO;
+    GLuint m_quadVBO;
+    GLuint m_instanceVBO;
+
+    ImpostorRenderer(const ImpostorRenderer&) = delete;
+    ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+};
@@ -0,0 +1,148 @@
+﻿#pragma once
+
+#include "../headers/obj_loader.h"
+#include "../headers/view.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+const char MESHLET_MAGIC[4] = { 'M', 'S', 'H', 'L' };
+const uint32_t MESHLET_VERSION = 2;
+
+/**
+ * @brief Кластер соседних треугольников сетки (в пространстве модели).
+ * * Треугольники кластера лежат в индексном буфере подряд: [FirstIndex, FirstIndex + IndexCount).
+ * * Конус нормалей: кластер целиком повёрнут задней стороной к наблюдателю в точке eye, если
+ * * dot(Center - eye, ConeAxis) >= ConeCutoff * |Center - eye| + Radius.
+ * * ConeCutoff == 1 - конус слишком широкий, кластер по нему не отсекается.
+ */
+struct Meshlet {
+    glm::vec3 Center;
+    float Radius;
+    glm::vec3 ConeAxis;
+    float ConeCutoff;
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+};
+
+/**
+ * @brief Команда непрямого рисования, раскладка как у glMultiDrawElementsIndirect.
+ */
+struct DrawElementsIndirectCommand {
+    uint32_t Count;
+    uint32_t InstanceCount;
+    uint32_t FirstIndex;
+    int32_t BaseVertex;
+    uint32_t BaseInstance;
+};
+
+/**
+ * @brief Отпечаток исходной сетки, по которому сохранённые кластеры сверяются с моделью.
+ * * TriangleCount - число невырожденных треугольников (по сваренным позициям),
+ * * Hash - FNV-1a по позициям и текстурным координатам всех вершин по порядку.
+ */
+struct MeshletSource {
+    uint32_t TriangleCount;
+    uint32_t Hash;
+};
+
+/**
+ * @brief Заголовок файла кластеров (.meshlets).
+ * * Далее подряд идут массивы VertexCount вершин, IndexCount индексов и MeshletCount кластеров.
+ * * SourceTriangleCount и SourceHash - отпечаток сетки, из которой построены кластеры.
+ */
+struct MeshletFileHeader {
+    char Magic[4];
+    uint32_t Version;
+    uint32_t VertexCount;
+    uint32_t IndexCount;
+    uint32_t MeshletCount;
+    uint32_t ConeCulling;
+    uint32_t SourceTriangleCount;
+    uint32_t SourceHash;
+};
+
+// Счётчики накапливаются между вызовами cullMeshlets; треугольники - по всем экземплярам.
+// Frames увеличивает вызывающий, один раз за кадр: за кадр cullMeshlets может вызываться несколько раз
+struct MeshletCullStats {
+    size_t Frames;
+    size_t Triangles;
+    size_t FrustumCulled;
+    size_t ConeCulled;
+    size_t Commands;
+};
+
+/**
+ * @brief Сетка, разбитая на кластеры не более чем из MESHLET_MAX_VERTICES вершин
+ * * и MESHLET_MAX_TRIANGLES треугольников.
+ * * Разбиение - предварительный шаг: его можно сохранить в файл (--build-meshlets)
+ * * и загружать вместо повторного построения.
+ * * Отсечение по конусу нормалей разрешается, только если сетка замкнута и
+ * * ориентирована согласованно: у открытой сетки видны обе стороны треугольников.
+ */
+class MeshletMesh {
+public:
+    MeshletMesh();
+
+    /**
+     * @brief Строит кластеры по развёрнутому списку треугольников (по три вершины, как в Model).
+     * * Одинаковые вершины объединяются, кластеры наращиваются жадно: к кластеру добавляется
+     * * соседний треугольник, добавляющий меньше новых вершин и ближе по нормали.
+     */
+    bool build(const std::vector<Vertex>& triangleVertices);
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // Построены ли кластеры (или загруженный файл) из этого списка треугольников
+    bool matchesSource(const std::vector<Vertex>& triangleVertices) const;
+
+    // Освобождает вершины и индексы (после загрузки в GPU); кластеры остаются для отсечения
+    void releaseGeometry();
+
+    const std::vector<Vertex>& getVertices() const { return m_vertices; }
+    const std::vector<uint32_t>& getIndices() const { return m_indices; }
+    const std::vector<Meshlet>& getMeshlets() const { return m_meshlets; }
+    bool isConeCullingAllowed() const { return m_coneCulling; }
+    const MeshletSource& getSource() const { return m_source; }
+
+private:
+    std::vector<Vertex> m_vertices;
+    std::vector<uint32_t> m_indices;
+    std::vector<Meshlet> m_meshlets;
+    bool m_coneCulling;
+    MeshletSource m_source;
+
+    /**
+     * @brief Переставляет кластеры (и их индексы) так, чтобы соседние в буфере смотрели
+     * * в близкие стороны: они отсекаются вместе, и выжившие сливаются в меньшее число команд.
+     */
+    void sortByConeAxis();
+};
+
+/**
+ * @brief Отпечаток развёрнутого списка треугольников (по три вершины, как в Model).
+ */
+MeshletSource computeMeshletSource(const std::vector<Vertex>& triangleVertices);
+
+/**
+ * @brief Путь файла кластеров рядом с моделью: models/planet.obj -> models/planet.meshlets.
+ */
+std::string getMeshletPath(const std::string& modelPath);
+
+/**
+ * @brief Отсекает кластеры каждого экземпляра по объединению пирамид видимости и
+ * * (если разрешено) по конусам нормалей для всех видов; выжившие кластеры
+ * * записываются командами непрямого рисования, соседние кластеры экземпляра
+ * * сливаются в одну команду.
+ * * Команда рисует viewCount экземпляров (по одному на вид) с матрицей экземпляра
+ * * BaseInstance, если делитель экземплярных атрибутов равен viewCount.
+ */
+void cullMeshlets(const MeshletMesh& mesh, const View* views, int viewCount, const glm::mat4* instances, size_t count,
+    std::vector<DrawElementsIndirectCommand>& commands, MeshletCullStats& stats);
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include "../headers/meshlet.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Рисует кластерную сетку командами непрямого рисования после отсечения cullMeshlets.
+ * * Вершины и индексы загружаются один раз; каждый кадр в GPU уходят только матрицы
+ * * экземпляров и список команд. Если есть GL_ARB_multi_draw_indirect, весь список
+ * * рисуется одним glMultiDrawElementsIndirect, иначе - по вызову на команду
+ * * (glDrawElementsInstancedBaseInstance). Без GL_ARB_base_instance путь недоступен.
+ * * Шейдер и его uniform-переменные выставляет вызывающий, как для Model::drawInstanced.
+ */
+class MeshletRenderer {
+public:
+    MeshletRenderer();
+    ~MeshletRenderer();
+
+    void upload(const MeshletMesh& mesh);
+
+    // Драйвер поддерживает нужные расширения и сетка загружена
+    bool isSupported() const;
+
+    /**
+     * @param instances Матрицы экземпляров, на которые ссылаются BaseInstance команд.
+     * @param viewCount Делитель экземплярных атрибутов (см. Model::setupInstanceBuffer).
+     */
+    void draw(const std::vector<glm::mat4>& instances, GLuint viewCount,
+        const std::vector<DrawElementsIndirectCommand>& commands);
+
+private:
+    GLuint m_VAO;
+    GLuint m_VBO;
+    GLuint m_EBO;
+    GLuint m_instanceVBO;
+    GLuint m_indirectBuffer;
+    GLsizei m_indexCount;
+
+    MeshletRenderer(const MeshletRenderer&) = delete;
+    MeshletRenderer& operator=(const MeshletRenderer&) = delete;
+};
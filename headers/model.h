@@ -1,4 +1,6 @@
-#pragma once
+﻿#pragma once
+
+#include "../headers/obj_loader.h"
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -7,27 +9,51 @@
 #include <iostream>
 
 
-struct Vertex {
-    glm::vec3 Position;
-    glm::vec2 TexCoords;
-};
-
-
 class Model {
 public:
     
-    Model(const char* path);
+    /**
+     * @param retainCpuData Оставить копию вершин в ОЗУ после загрузки в GPU
+     * (нужна, например, для построения BVH). Освобождается вызовом releaseCpuData().
+     */
+    Model(const char* path, bool retainCpuData = false);
 
     ~Model();
 
-    void draw();
+    /**
+     * @param viewCount Число видов: при viewCount > 1 сетка рисуется viewCount экземплярами,
+     * * по одному на вид (см. MultiView).
+     */
+    void draw(GLuint viewCount = 1);
     void drawInstanced(GLuint instanceCount);
-    void setupInstanceBuffer(const std::vector<glm::mat4>& matrices);
+
+    /**
+     * @param divisor Сколько подряд идущих экземпляров читают одну матрицу;
+     * * при рисовании в несколько видов равен числу видов.
+     */
+    void setupInstanceBuffer(const std::vector<glm::mat4>& matrices, GLuint divisor = 1);
+
+    // Пусто, если копия вершин в ОЗУ уже освобождена
+    const std::vector<Vertex>& getVertices() const { return vertices; }
+    void releaseCpuData();
+
+    GLsizei getVertexCount() const { return vertexCount; }
+    const std::string& getName() const { return name; }
+
+    // Радиус сферы с центром в начале координат модели, содержащей все вершины
+    float getBoundingRadius() const { return boundingRadius; }
+    const glm::vec3& getBoundsMin() const { return boundsMin; }
+    const glm::vec3& getBoundsMax() const { return boundsMax; }
 
 private:
     GLuint VAO, VBO, instanceVBO;
 
     std::vector<Vertex> vertices;
+    GLsizei vertexCount;
+    float boundingRadius;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    std::string name;
 
     void loadModel(const std::string& path);
     void setupMesh();
@@ -0,0 +1,113 @@
+﻿#pragma once
+
+#include "../headers/camera.h"
+#include "../headers/view.h"
+#include "../headers/shader.h"
+#include "../headers/gpu_timer.h"
+
+#include <glm/glm.hpp>
+#include <chrono>
+#include <ostream>
+
+// Совпадает с размером массивов viewProjections/viewRects в вершинном шейдере
+const int MAX_VIEWS = 4;
+
+const float STEREO_EYE_SEPARATION = 0.5f; // Расстояние между глазами в мировых единицах
+const float OVERVIEW_DISTANCE = 200.0f;   // Удаление обзорных камер от центра сцены
+
+enum View_Layout {
+    VIEW_LAYOUT_SINGLE, // Один вид на всё окно
+    VIEW_LAYOUT_STEREO, // Стерео: левый и правый глаз в половинах окна
+    VIEW_LAYOUT_QUAD    // Камера и три обзорных вида (сверху, сбоку, спереди) в четвертях окна
+};
+
+const char* getViewLayoutName(View_Layout layout);
+
+/**
+ * @brief Набор видов, которые рисуются за один проход.
+ * * Каждый экземплярный вызов выполняется один раз с числом экземпляров,
+ * * умноженным на число видов: вершинный шейдер берёт вид как gl_InstanceID % viewCount
+ * * и переносит вершину в прямоугольник этого вида внутри окна, отсекая всё,
+ * * что выходит за его границы, через gl_ClipDistance.
+ * * Отсечение и выбор детализации выполняются по объединению пирамид видимости.
+ */
+class MultiView {
+public:
+    MultiView();
+
+    /**
+     * @brief Строит виды раскладки для камеры и окна размером width x height.
+     */
+    void setup(View_Layout layout, const Camera& camera, int width, int height);
+
+    /**
+     * @brief Возвращает набор из одного вида index на его прямоугольнике окна
+     * * (для рисования видов по очереди).
+     */
+    MultiView extractView(int index) const;
+
+    /**
+     * @brief Устанавливает glViewport и униформы видов. Шейдер должен быть активен.
+     */
+    void apply(const Shader& shader) const;
+
+    // Сфера видна хотя бы в одном виде
+    bool isSphereVisible(const glm::vec3& center, float radius) const;
+
+    /**
+     * @brief Наибольший экранный диаметр сферы в пикселях среди видов, где она видна;
+     * * 0, если сфера не видна ни в одном виде.
+     */
+    float getProjectedSize(const glm::vec3& center, float radius) const;
+
+    // Индекс вида, в прямоугольник которого попадает точка windowNdc (NDC окна); -1 - ни в один
+    int getViewAt(const glm::vec2& windowNdc) const;
+
+    View_Layout getLayout() const { return m_layout; }
+    int getViewCount() const { return m_viewCount; }
+    const View& getView(int index) const { return m_views[index]; }
+    const View* getViews() const { return m_views; }
+
+private:
+    View_Layout m_layout;
+    View m_views[MAX_VIEWS];
+    int m_viewCount;
+    int m_viewportX;
+    int m_viewportY;
+    int m_viewportWidth;
+    int m_viewportHeight;
+
+    void addView(const glm::mat4& viewMatrix, const glm::vec3& position, float fovY,
+        const glm::vec4& rect, int windowWidth, int windowHeight);
+};
+
+/**
+ * @brief Сравнение рисования всех видов за один проход с рисованием видов по очереди.
+ * * Первые framesPerPath кадров рисуются за один проход, следующие — по очереди;
+ * * для каждого способа замеряется время отправки команд на CPU и время GPU.
+ */
+class MultiViewBenchmark {
+public:
+    MultiViewBenchmark();
+
+    void start(int framesPerPath, int viewCount);
+    bool isRunning() const { return m_running; }
+
+    // Текущий кадр рисуется по видам по очереди
+    bool isNaivePass() const { return m_frame >= m_framesPerPath; }
+
+    // Оборачивают рисование кадра
+    void beginFrame();
+    void endFrame(std::ostream& out);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    bool m_running;
+    int m_framesPerPath;
+    int m_frame;
+    int m_viewCount;
+    Clock::time_point m_frameStart;
+    double m_cpuMs[2];
+    GpuTimer m_gpuTimers[2];
+};
@@ -0,0 +1,27 @@
+﻿#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <istream>
+
+
+struct Vertex {
+    glm::vec3 Position;
+    glm::vec2 TexCoords;
+};
+
+/**
+ * @brief Разбор OBJ без обращений к OpenGL.
+ * * Читает позиции (v), текстурные координаты (vt) и грани (f v/vt ...);
+ * * многоугольники разбиваются веером на треугольники, вершины разворачиваются
+ * * (по три на треугольник). Результат дописывается в vertices.
+ * @param sourceName Имя источника для сообщений об ошибках.
+ * @return false при ошибке разбора грани.
+ */
+bool parseObj(std::istream& in, std::vector<Vertex>& vertices, const std::string& sourceName);
+
+/**
+ * @brief Открывает файл и разбирает его parseObj.
+ */
+bool loadObj(const std::string& path, std::vector<Vertex>& vertices);
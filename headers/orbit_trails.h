@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include "../headers/shader.h"
+#include "../headers/scene.h"
+#include "../headers/multi_view.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+const int ORBIT_TRAIL_LENGTH = 128;                 // Точек в следе каждого тела
+const float ORBIT_TRAIL_SAMPLE_INTERVAL = 0.1f;     // Секунд между точками следа
+const size_t ORBIT_TRAIL_BUDGET = 64u * 1024u * 1024u; // Предел памяти кольца в байтах
+
+/**
+ * @brief Следы орбит всех тел в кольцевом буфере GPU фиксированного размера.
+ * * Буфер (буферная текстура RGBA32F) - historyLength строк по bodyCount позиций;
+ * * строка head - самые свежие позиции. Каждый кадр в неё загружаются текущие
+ * * позиции тел (bodyCount * 4 float), раз в sampleInterval секунд head сдвигается,
+ * * и предыдущая строка остаётся точкой следа. Выделений памяти по кадрам нет.
+ * * Все следы во всех видах рисуются одним экземплярным вызовом GL_LINE_STRIP:
+ * * экземпляр - тело в виде, вершина - возраст точки; шейдер читает кольцо
+ * * со смещением от head, прозрачность падает с возрастом.
+ * * Длина истории уменьшается, если кольцо не помещается в ORBIT_TRAIL_BUDGET
+ * * или в GL_MAX_TEXTURE_BUFFER_SIZE.
+ */
+class OrbitTrails {
+public:
+    OrbitTrails(int historyLength = ORBIT_TRAIL_LENGTH, float sampleInterval = ORBIT_TRAIL_SAMPLE_INTERVAL);
+    ~OrbitTrails();
+
+    /**
+     * @brief Записывает позиции тел в кольцо. При смене числа тел кольцо
+     * * перераспределяется и следы начинаются заново.
+     */
+    void append(const CelestialBody* bodies, size_t count, float deltaTime);
+
+    // Забывает накопленные точки (следы начнутся с текущих позиций)
+    void clear();
+
+    void draw(const MultiView& views);
+
+    int getHistoryLength() const { return m_historyLength; }
+
+private:
+    Shader m_shader;
+    GLuint m_VAO;
+    GLuint m_buffer;
+    GLuint m_texture;
+
+    int m_requestedLength;
+    int m_historyLength;
+    float m_sampleInterval;
+    float m_sinceSample;
+    size_t m_bodyCount;
+    int m_head;
+    int m_sampleCount;  // Заполненных строк кольца, не больше m_historyLength
+    std::vector<glm::vec4> m_staging;
+
+    void allocate(size_t bodyCount);
+
+    OrbitTrails(const OrbitTrails&) = delete;
+    OrbitTrails& operator=(const OrbitTrails&) = delete;
+};
@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+enum Resource_Category {
+    RESOURCE_GPU_BUFFER,  // Вершинные, экземплярные, pixel-pack буферы
+    RESOURCE_GPU_TEXTURE, // Текстуры вместе с цепочкой mip-уровней
+    RESOURCE_CPU_MESH,    // Копии сеток, оставленные в оперативной памяти
+    RESOURCE_CATEGORY_COUNT
+};
+
+// Рендербуферы учитываются как текстуры; их имена пересекаются с именами текстур,
+// поэтому к id рендербуфера добавляется этот признак в старших разрядах
+const uint64_t RESOURCE_RENDERBUFFER_TAG = uint64_t(1) << 32;
+
+/**
+ * @brief Учёт памяти, занятой ресурсами, с бюджетами по категориям.
+ * * Владельцы ресурсов сообщают размер при создании/изменении и снимают учёт
+ * * при удалении. Ресурс идентифицируется парой (категория, id): для объектов
+ * * OpenGL это имя объекта, для данных в ОЗУ — адрес владельца.
+ * * При превышении бюджета категории в std::cerr выводится предупреждение.
+ */
+class ResourceTracker {
+public:
+    static ResourceTracker& instance();
+
+    /**
+     * @brief Регистрирует ресурс или обновляет его размер.
+     */
+    void setUsage(Resource_Category category, uint64_t id, size_t bytes, const std::string& label);
+
+    void release(Resource_Category category, uint64_t id);
+
+    void setBudget(Resource_Category category, size_t bytes);
+    size_t getBudget(Resource_Category category) const;
+
+    size_t getTotal(Resource_Category category) const;
+    size_t getPeak(Resource_Category category) const;
+    size_t getResourceCount(Resource_Category category) const;
+
+    /**
+     * @brief Печатает итоги по категориям и самые крупные ресурсы каждой категории.
+     */
+    void report(std::ostream& out, size_t topCount = 5) const;
+
+private:
+    struct Entry {
+        size_t Bytes;
+        std::string Label;
+    };
+
+    struct CategoryState {
+        std::map<uint64_t, Entry> Entries;
+        size_t Total;
+        size_t Peak;
+        size_t Budget; // 0 - без ограничения
+        bool OverBudget;
+    };
+
+    CategoryState m_categories[RESOURCE_CATEGORY_COUNT];
+    mutable std::mutex m_mutex;
+
+    ResourceTracker();
+
+    ResourceTracker(const ResourceTracker&) = delete;
+    ResourceTracker& operator=(const ResourceTracker&) = delete;
+};
@@ -0,0 +1,111 @@
+﻿#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+/**
+ * @brief Состояние одного небесного тела.
+ * * Структура намеренно тривиально копируемая и без указателей: в таком же виде
+ * * тела лежат в бинарном файле сцены, поэтому массив тел копируется из
+ * * отображённого в память файла одним memcpy, без разбора и аллокаций на тело.
+ */
+struct CelestialBody {
+    glm::vec3 Position;
+    float OrbitRadius;
+    float OrbitSpeed;
+    float RotationSpeed;
+    float Scale;
+    float OrbitAngle;
+    float RotationAngle;
+
+    uint32_t TextureIndex; // Индекс в таблице текстур сцены
+};
+
+static_assert(std::is_trivially_copyable<CelestialBody>::value, "CelestialBody must stay trivially copyable");
+static_assert(sizeof(CelestialBody) == 40, "CelestialBody layout is part of the binary scene format");
+
+const char SCENE_MAGIC[4] = { 'S', 'S', 'C', 'N' };
+const uint32_t SCENE_VERSION = 1;
+
+/**
+ * @brief Заголовок бинарного файла сцены (.sceneb).
+ * * Далее идут таблица путей текстур (uint32 длина + символы) и, с выравниванием
+ * * до 16 байт, массив BodyCount структур CelestialBody.
+ */
+struct SceneFileHeader {
+    char Magic[4];
+    uint32_t Version;
+    uint32_t TextureCount;
+    uint32_t BodyStride;
+    uint64_t BodyCount;
+    uint64_t TextureTableOffset;
+    uint64_t BodiesOffset;
+    CelestialBody Sun;
+};
+
+/**
+ * @brief Описание сцены: Солнце, тела на орбитах и таблица текстур.
+ * * Умеет читать текстовый формат (.scene) для ручного редактирования и
+ * * отображать в память скомпилированный бинарный формат (.sceneb).
+ * * Формат определяется по сигнатуре файла, а не по расширению.
+ *
+ * Текстовый формат, по одной директиве в строке ('#' — комментарий):
+ *   texture <имя> <путь>
+ *   sun <текстура> <масштаб> <скорость_вращения>
+ *   body <текстура> <радиус_орбиты> <скорость_орбиты> <скорость_вращения> <масштаб> <начальный_угол>
+ *   ring <текстура> <количество> <внутр_радиус> <внеш_радиус> <мин_масштаб> <макс_масштаб> <скорость_орбиты> <seed>
+ */
+class Scene {
+public:
+    Scene();
+
+    ~Scene();
+
+    /**
+     * @brief Загружает сцену из текстового или бинарного файла.
+     * @return false, если файл не удалось открыть или разобрать.
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Сохраняет сцену в бинарном формате для последующего отображения в память.
+     */
+    bool saveBinary(const std::string& path) const;
+
+    const CelestialBody& getSun() const { return m_sun; }
+    const CelestialBody* getBodies() const { return m_bodies; }
+    size_t getBodyCount() const { return m_bodyCount; }
+    const std::vector<std::string>& getTexturePaths() const { return m_texturePaths; }
+
+    // true, если тела читаются напрямую из отображённого в память файла
+    bool isMapped() const { return m_mapping != nullptr; }
+
+private:
+    CelestialBody m_sun;
+    std::vector<std::string> m_texturePaths;
+
+    // Тела, разобранные из текстового файла (пусто для бинарной сцены)
+    std::vector<CelestialBody> m_parsedBodies;
+
+    const CelestialBody* m_bodies;
+    size_t m_bodyCount;
+
+    void* m_mapping;
+    size_t m_mappingSize;
+#ifdef _WIN32
+    void* m_fileHandle;
+    void* m_mappingHandle;
+#endif
+
+    bool loadText(const std::string& path);
+    bool mapBinary(const std::string& path);
+    void unmap();
+    void reset();
+
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+};
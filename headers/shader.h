@@ -27,6 +27,11 @@ public:
      */
     Shader();
 
+    /**
+     * Конструктор: создает шейдерную программу из переданных исходных кодов.
+     */
+    Shader(const char* vertexCode, const char* fragmentCode);
+
     /**
      *Деструктор: удаляет шейдерную программу из памяти GPU.
      */
@@ -42,10 +47,17 @@ public:
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
 
+    void setVec2(const std::string& name, const glm::vec2& value) const;
+
     void setVec3(const std::string& name, const glm::vec3& value) const;
     void setVec3(const std::string& name, float x, float y, float z) const;
 
+    void setVec4(const std::string& name, const glm::vec4& value) const;
+    // Массив униформ: name - имя массива без индекса
+    void setVec4Array(const std::string& name, const glm::vec4* values, int count) const;
+
     void setMat4(const std::string& name, const glm::mat4& mat) const;
+    void setMat4Array(const std::string& name, const glm::mat4* mats, int count) const;
 
 private:
     /**
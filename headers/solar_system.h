@@ -1,46 +1,188 @@
-#pragma once
+﻿#pragma once
 
 #include "../headers/shader.h"
 #include "../headers/model.h"
 #include "../headers/texture.h"
+#include "../headers/scene.h"
+#include "../headers/bvh.h"
+#include "../headers/camera.h"
+#include "../headers/texture_streamer.h"
+#include "../headers/multi_view.h"
+#include "../headers/impostor.h"
+#include "../headers/gpu_timer.h"
+#include "../headers/body_simulation.h"
+#include "../headers/meshlet.h"
+#include "../headers/meshlet_renderer.h"
+#include "../headers/orbit_trails.h"
+#include "../headers/spatial_hash.h"
 
 #include <vector>
+#include <string>
+#include <ostream>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-struct CelestialBody {
-    glm::vec3 Position;
-    float OrbitRadius;
-    float OrbitSpeed;
-    float RotationSpeed;
-    float Scale;
-    float OrbitAngle;
-    float RotationAngle;
-
-    Texture* texture;
-    glm::mat4 ModelMatrix;
+// Зазор между поверхностями тел, меньше которого сближение попадает в отчёт
+const float CLOSE_APPROACH_DISTANCE = 1.0f;
+
+struct PickResult {
+    bool Hit;
+    bool IsSun;
+    size_t BodyIndex; // Индекс планеты, если IsSun == false
+    float Distance;
 };
 
 
 class SolarSystem {
 public:
 
-    SolarSystem(Shader* shader, Model* model);
+    SolarSystem(Shader* shader, Model* model, const std::string& scenePath = "scenes/solar_system.scene");
 
     ~SolarSystem();
 
     void update(float deltaTime);
 
-    void draw();
+    /**
+     * @brief Рисует систему во все виды набора за один проход.
+     * * Тела, не попадающие ни в одну пирамиду видимости, отбрасываются,
+     * * видимые упаковываются в экземплярный буфер подряд. Планеты, которые
+     * * на экране меньше IMPOSTOR_BLEND_SIZE пикселей, рисуются импосторами.
+     */
+    void draw(const MultiView& views);
+
+    /**
+     * @brief Находит ближайшее тело на луче (мировые координаты, Direction нормализован).
+     * * Сначала отбор по BVH ограничивающих сфер, затем точная проверка по треугольникам сетки.
+     */
+    PickResult pick(const Ray& ray) const;
+
+    /**
+     * @brief Сообщает стримеру экранный размер тел для каждой текстуры.
+     * * Размер - диаметр ограничивающей сферы тела в пикселях, наибольший
+     * * среди видов, в которых тело видно.
+     */
+    void requestTextureDetail(TextureStreamer& streamer, const MultiView& views) const;
+
+    // Число планет, прошедших отсечение в последнем draw()
+    size_t getVisibleBodyCount() const { return m_visibleBodyCount; }
+    // Планеты хранятся упорядоченными по текстуре; индексы тел в pick() и парах - в этом порядке
+    size_t getBodyCount() const { return m_planets.size(); }
+
+    void setImpostorsEnabled(bool enabled) { m_impostorsEnabled = enabled; }
+    bool areImpostorsEnabled() const { return m_impostorsEnabled; }
+
+    /**
+     * @brief Печатает, сколько экземпляров в среднем за кадр нарисовано сеткой и импостором,
+     * * время GPU обоих проходов и оценку сэкономленного времени; сбрасывает накопленное.
+     */
+    void reportImpostors(std::ostream& out);
+
+    // Рисование планет кластерами с отсечением (если драйвер поддерживает) или всей сеткой
+    void setMeshletsEnabled(bool enabled) { m_meshletsEnabled = enabled; }
+    bool areMeshletsEnabled() const { return m_meshletsEnabled; }
+
+    /**
+     * @brief Печатает долю треугольников, отсечённых по пирамиде видимости и по конусам нормалей,
+     * * время отсечения на CPU и время GPU прохода сеток в обоих режимах; сбрасывает накопленное.
+     * * Для сравнения режимов переключите их (F10) между двумя отчётами.
+     */
+    void reportMeshlets(std::ostream& out);
+
+    // Выключенные следы не обновляются; при включении начинаются заново
+    void setOrbitTrailsEnabled(bool enabled) {
+        if (enabled && !m_orbitTrailsEnabled)
+            m_orbitTrails.clear();
+        m_orbitTrailsEnabled = enabled;
+    }
+    bool areOrbitTrailsEnabled() const { return m_orbitTrailsEnabled; }
+
+    /**
+     * @brief Пары планет с зазором между ограничивающими сферами меньше distance
+     * * (0 - столкновения). Пространственный хеш перестраивается в каждом update().
+     */
+    void findCloseApproaches(float distance, std::vector<ProximityPair>& pairs) const {
+        m_spatialHash.pairsCloserThan(distance, pairs);
+    }
+
+    // Планеты с зазором до планеты body меньше distance; в парах A = body
+    void findNeighbors(size_t body, float distance, std::vector<ProximityPair>& result) const {
+        m_spatialHash.neighbors(body, distance, result);
+    }
+
+    /**
+     * @brief Печатает число столкновений и сближений ближе distance, самые близкие пары
+     * * и время перестройки хеша и запроса.
+     */
+    void reportProximity(std::ostream& out, float distance = CLOSE_APPROACH_DISTANCE) const;
+
+    const std::vector<Texture*>& getTextures() const { return m_textures; }
 
 private:
     Shader* m_shader;
     Model* m_model;
 
     CelestialBody m_sun;
+    glm::mat4 m_sunMatrix;
     std::vector<CelestialBody> m_planets;
+    std::vector<Texture*> m_textures;
     
     std::vector<glm::mat4> instanceMatrices;
+    size_t m_visibleBodyCount;
+
+    // Планеты с одной текстурой идут подряд: группа рисуется одним экземплярным вызовом
+    // и имеет свой атлас импосторов
+    struct TextureBatch {
+        uint32_t TextureIndex;
+        size_t First;
+        size_t Count;
+        ImpostorAtlas* Atlas;
+        std::vector<glm::mat4> MeshInstances;
+        std::vector<glm::mat4> ImpostorInstances;
+        std::vector<DrawElementsIndirectCommand> MeshletCommands;
+    };
+    std::vector<TextureBatch> m_textureBatches;
+
+    // Ограничивающие сферы: [0] - Солнце, [i + 1] - планета i
+    std::vector<BoundingSphere> m_bounds;
+    InstanceBVH m_instanceBvh;
+    TriangleBVH m_meshBvh;
+
+    ImpostorRenderer m_impostorRenderer;
+    bool m_impostorsEnabled;
+
+    // Накопленное с последнего reportImpostors()
+    struct ImpostorStats {
+        size_t Frames;
+        size_t MeshInstances;
+        size_t ImpostorInstances;
+        size_t BlendedInstances; // Нарисованы и сеткой, и импостором
+    };
+    ImpostorStats m_impostorStats;
+    GpuTimer m_meshTimer;
+    GpuTimer m_impostorTimer;
+
+    // Кластеры сетки: на CPU остаются только сферы и конусы для отсечения
+    MeshletMesh m_meshletMesh;
+    MeshletRenderer m_meshletRenderer;
+    bool m_meshletsEnabled;
+
+    // Накопленное с последнего reportMeshlets(); [0] - вся сетка, [1] - кластеры
+    MeshletCullStats m_meshletStats;
+    double m_meshletCullMs;
+    GpuTimer m_meshPathTimers[2];
+    size_t m_meshPathFrames[2];
+    size_t m_meshPathInstances[2];
+
+    OrbitTrails m_orbitTrails;
+    bool m_orbitTrailsEnabled;
+
+    // Построен по m_bounds[1..], индексы в парах - индексы планет
+    SpatialHash m_spatialHash;
+    double m_spatialHashBuildMs;
 
+    bool loadScene(const std::string& path);
+    void groupByTexture();
+    void setupMeshlets();
     void initializeSystem();
+    Texture* getTexture(uint32_t index) const;
 };
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include "../headers/bvh.h"
+#include "../headers/worker_pool.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Пара тел, сблизившихся меньше чем на заданное расстояние (A < B).
+ * * Gap - расстояние между поверхностями ограничивающих сфер; Gap < 0 - сферы пересекаются.
+ */
+struct ProximityPair {
+    uint32_t A;
+    uint32_t B;
+    float Gap;
+};
+
+/**
+ * @brief Равномерная сетка с хешированием ячеек для поиска сближений и столкновений тел.
+ * * Пространство делится на кубические ячейки, ячейка центра каждой сферы хешируется
+ * * в таблицу, и тела сортируются поразрядно по номеру корзины; сортировка и вычисление
+ * * ключей идут параллельно по частям массива на постоянных рабочих потоках. Запрос проверяет только корзины ячеек,
+ * * до которых сфера может дотянуться, и точно сравнивает расстояние между поверхностями
+ * * (радиус - радиус сетки, умноженный на Scale тела).
+ * * Сферы не копируются: массив должен жить и не меняться до следующего build, как в InstanceBVH.
+ */
+class SpatialHash {
+public:
+    SpatialHash();
+
+    /**
+     * @param typicalDistance Расстояние, для которого подбирается размер ячейки: запрос
+     * * с таким расстоянием просматривает 3 x 3 x 3 ячейки. Запросы с другим расстоянием тоже верны.
+     * @param threadCount 0 - по числу ядер.
+     */
+    void build(const BoundingSphere* spheres, size_t count, float typicalDistance, unsigned threadCount = 0);
+
+    /**
+     * @brief Все пары, у которых зазор между поверхностями меньше distance
+     * * (distance = 0 - столкновения). Порядок пар детерминирован.
+     */
+    void pairsCloserThan(float distance, std::vector<ProximityPair>& pairs, unsigned threadCount = 0) const;
+
+    /**
+     * @brief Тела, зазор до которых от тела body меньше distance; в парах A = body.
+     */
+    void neighbors(size_t body, float distance, std::vector<ProximityPair>& result) const;
+
+    size_t getBodyCount() const { return m_count; }
+    float getCellSize() const { return m_cellSize; }
+    size_t getTableSize() const { return m_cellStart.empty() ? 0 : m_cellStart.size() - 1; }
+
+private:
+    const BoundingSphere* m_spheres;
+    size_t m_count;
+    float m_cellSize;
+    float m_maxRadius;
+    uint32_t m_mask;
+    bool m_compactNeighborhood;  // Корзины окна 3 x 3 x 3 ячеек различны
+
+    std::vector<uint32_t> m_keys;              // Корзины тел в порядке m_sorted
+    std::vector<uint32_t> m_cellStart;         // Начало корзины в m_sorted, размер таблицы + 1
+    std::vector<uint32_t> m_sorted;            // Индексы тел по корзинам
+    std::vector<glm::vec4> m_sortedSpheres;    // Центр и радиус в том же порядке
+    std::vector<uint32_t> m_scratchKeys;       // Второй буфер поразрядной сортировки
+    std::vector<uint32_t> m_scratchIndices;
+    std::vector<uint32_t> m_digitCounts;       // Гистограммы разряда по частям
+    mutable WorkerPool m_pool;
+
+    uint32_t bucketOf(const glm::ivec3& cell) const;
+
+    /**
+     * @brief Корзины ячеек, пересекающих куб center +- reach, без повторов.
+     */
+    void collectBuckets(const glm::vec3& center, float reach, std::vector<uint32_t>& buckets) const;
+};
+
+/**
+ * @brief Эталонный перебор всех пар за O(n^2) для проверки и сравнения в бенчмарках.
+ */
+void bruteForcePairs(const BoundingSphere* spheres, size_t count, float distance, std::vector<ProximityPair>& pairs);
@@ -1,15 +1,22 @@
-#pragma once
+﻿#pragma once
 
 #include <GL/glew.h>
 #include <string>
+#include <vector>
 #include <iostream>
 
+// Уровни не больше этого размера у потоковых текстур резидентны всегда
+const int STREAM_TAIL_SIZE = 64;
 
 class Texture {
 public:
     GLuint ID;
 
-    Texture(const char* path);
+    /**
+     * @param streamed Если true, в GPU сразу загружается только "хвост" mip-цепочки
+     * (уровни не больше STREAM_TAIL_SIZE), а более детальные уровни подгружает TextureStreamer.
+     */
+    Texture(const char* path, bool streamed = false);
 
     ~Texture();
 
@@ -17,10 +24,55 @@ public:
 
     void unbind();
 
+    const std::string& getPath() const { return path; }
+    bool isStreamed() const { return streamed; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getChannels() const { return nrChannels; }
+
+    int getLevelCount() const { return levelCount; }
+    int getTailLevel() const { return tailLevel; }
+    int getResidentBaseLevel() const { return residentBaseLevel; }
+
+    // Объём видеопамяти под все mip-уровни (оценка по формату данных)
+    size_t getMipChainBytes() const;
+    size_t getLevelBytes(int level) const;
+    size_t getResidentBytes() const;
+
+    /**
+     * @brief Загружает в GPU один mip-уровень; pixels должны иметь размер этого уровня.
+     */
+    void uploadLevel(int level, const unsigned char* pixels);
+
+    /**
+     * @brief Делает уровни начиная с level доступными для выборки (GL_TEXTURE_BASE_LEVEL).
+     */
+    void setResidentBaseLevel(int level);
+
+    /**
+     * @brief Освобождает видеопамять уровней детальнее level.
+     */
+    void evictLevelsBelow(int level);
+
+    /**
+     * @brief Уменьшает изображение вдвое по каждой оси усреднением блоков 2x2.
+     */
+    static std::vector<unsigned char> downsample(const unsigned char* pixels, int w, int h, int channels);
+
 private:
     int width;
     int height;
     int nrChannels;
+    GLenum format;
+
+    std::string path;
+    bool streamed;
+    int levelCount;
+    int tailLevel;
+    int residentBaseLevel;
+
+    void getLevelSize(int level, int& w, int& h) const;
+    void updateResidency();
 
     Texture(const Texture&) = delete;
     Texture& operator=(const Texture&) = delete;
@@ -0,0 +1,90 @@
+﻿#pragma once
+
+#include "../headers/texture.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ostream>
+
+/**
+ * @brief Потоковая подгрузка mip-уровней по экранному размеру объектов.
+ * * Каждый кадр для каждой текстуры сообщается максимальный экранный размер
+ * * (в пикселях) объектов, которые её используют. Из него вычисляется нужный
+ * * mip-уровень. Детальные уровни, которые больше не нужны, сразу освобождаются,
+ * * недостающие — декодируются и уменьшаются в фоновом потоке и загружаются в GPU
+ * * на основном потоке с ограничением объёма загрузки за кадр.
+ * * Суммарный объём резидентных уровней держится в пределах бюджета: при нехватке
+ * * огрубляются текстуры с самыми дорогими детальными уровнями.
+ */
+class TextureStreamer {
+public:
+    /**
+     * @param vramBudget Бюджет видеопамяти на потоковые текстуры в байтах.
+     * @param uploadBytesPerFrame Сколько байт mip-уровней можно загрузить в GPU за кадр.
+     */
+    TextureStreamer(size_t vramBudget, size_t uploadBytesPerFrame = 8u * 1024u * 1024u);
+
+    ~TextureStreamer();
+
+    void registerTexture(Texture* texture);
+
+    /**
+     * @brief Сообщает, что текстура видна на экране размером pixelSize пикселей.
+     */
+    void requestCoverage(Texture* texture, float pixelSize);
+
+    /**
+     * @brief Пересчитывает нужные уровни, освобождает лишние, ставит загрузки в очередь
+     * * и загружает в GPU готовые уровни. Вызывать раз в кадр после requestCoverage.
+     */
+    void update();
+
+    size_t getResidentBytes() const;
+    size_t getBudget() const { return m_budget; }
+
+    void report(std::ostream& out) const;
+
+private:
+    struct Entry {
+        Texture* texture;
+        float coverage;     // Максимальный экранный размер за кадр
+        int requiredLevel;  // Уровень по экранному размеру
+        int targetLevel;    // Уровень с учётом бюджета
+        bool loadPending;
+    };
+
+    struct LoadJob {
+        Texture* texture;
+        std::string path;
+        int firstLevel; // Загрузить уровни [firstLevel, lastLevel)
+        int lastLevel;
+    };
+
+    struct LoadResult {
+        Texture* texture;
+        int firstLevel;
+        std::vector<std::vector<unsigned char>> levels;
+    };
+
+    std::vector<Entry> m_entries;
+    size_t m_budget;
+    size_t m_uploadBytesPerFrame;
+
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_jobsChanged;
+    std::deque<LoadJob> m_jobs;
+    std::deque<LoadResult> m_results;
+    bool m_stopping;
+
+    Entry* findEntry(Texture* texture);
+    void applyBudget();
+    void applyResults();
+    void workerLoop();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+};
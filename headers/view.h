@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#include <glm/glm.hpp>
+
+const float VIEW_NEAR_PLANE = 0.1f;
+const float VIEW_FAR_PLANE = 500.0f;
+
+/**
+ * @brief Плоскости пирамиды видимости: точка внутри, если dot(xyz, p) + w >= 0 для всех.
+ */
+struct Frustum {
+    glm::vec4 Planes[6];
+};
+
+struct View {
+    glm::mat4 ViewMatrix;
+    glm::mat4 Projection;
+    glm::mat4 ViewProjection;
+    glm::vec3 Position;
+    glm::vec4 Rect;        // Смещение (xy) и масштаб (zw) прямоугольника вида в NDC окна
+    int ViewportX;         // Прямоугольник вида в пикселях (начало - левый нижний угол)
+    int ViewportY;
+    int ViewportWidth;
+    int ViewportHeight;
+    float FocalPixels;     // Фокусное расстояние в пикселях по вертикали
+    Frustum ViewFrustum;
+};
+
+/**
+ * @brief Строит вид с перспективной проекцией для прямоугольника rect окна windowWidth x windowHeight.
+ */
+View buildView(const glm::mat4& viewMatrix, const glm::vec3& position, float fovY,
+    const glm::vec4& rect, int windowWidth, int windowHeight);
+
+/**
+ * @brief Извлекает плоскости пирамиды видимости из матрицы projection * view (метод Грибба-Хартманна).
+ */
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+bool isSphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
+
+/**
+ * @brief Наибольший экранный диаметр сферы в пикселях среди видов, где она видна;
+ * * 0, если сфера не видна ни в одном виде.
+ */
+float getProjectedSize(const View* views, int viewCount, const glm::vec3& center, float radius);
+
+/**
+ * @brief Нормализованное направление луча из view.Position через точку окна.
+ * * windowNdc - координаты точки в NDC всего окна; точка переводится в прямоугольник
+ * * вида и обращается матрицей ViewProjection.
+ */
+glm::vec3 getRayDirection(const View& view, const glm::vec2& windowNdc);
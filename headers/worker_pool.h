@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Постоянные рабочие потоки для параллельных циклов, выполняемых каждый кадр.
+ * * Потоки создаются при первом вызове run и между вызовами ждут на условной переменной,
+ * * поэтому run не платит за создание и завершение потоков.
+ */
+class WorkerPool {
+public:
+    // threadCount - число потоков вместе с вызывающим; 0 - по числу ядер
+    explicit WorkerPool(unsigned threadCount = 0);
+    ~WorkerPool();
+
+    /**
+     * @brief Вызывает work(part) для каждого part из [0, partCount) и ждёт завершения всех частей.
+     * * Части разбирают рабочие потоки и вызывающий поток; частей может быть больше, чем потоков.
+     * * Вызовы run из разных потоков выполняются по очереди.
+     */
+    void run(unsigned partCount, const std::function<void(unsigned)>& work);
+
+    unsigned getThreadCount() const { return m_threadCount; }
+
+private:
+    unsigned m_threadCount;
+    std::vector<std::thread> m_workers;
+    std::mutex m_runMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_workReady;
+    std::condition_variable m_workDone;
+
+    // Текущий вызов run; защищено m_mutex
+    const std::function<void(unsigned)>* m_work;
+    unsigned m_partCount;
+    unsigned m_nextPart;
+    unsigned m_pendingParts;
+    bool m_stopping;
+
+    void workerLoop();
+
+    /**
+     * @brief Берёт и выполняет следующую часть (m_mutex захвачен, на время работы отпускается).
+     * @return false, если частей не осталось.
+     */
+    bool runNextPart(std::unique_lock<std::mutex>& lock);
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+};
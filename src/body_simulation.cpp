@@ -0,0 +1,66 @@
+#include "../headers/body_simulation.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+
+glm::mat4 advanceSun(CelestialBody& sun, float deltaTime) {
+    sun.RotationAngle += sun.RotationSpeed * deltaTime;
+
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::scale(model, glm::vec3(sun.Scale));
+    model = glm::rotate(model, glm::radians(sun.RotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    return model;
+}
+
+void advanceBodies(CelestialBody* bodies, size_t count, float deltaTime, glm::mat4* matrices) {
+    for (size_t i = 0; i < count; ++i) {
+        CelestialBody& p = bodies[i];
+        p.OrbitAngle += p.OrbitSpeed * deltaTime;
+
+        p.Position.x = p.OrbitRadius * cos(glm::radians(p.OrbitAngle));
+        p.Position.z = p.OrbitRadius * sin(glm::radians(p.OrbitAngle));
+
+        p.RotationAngle += p.RotationSpeed * deltaTime;
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, p.Position);
+        model = glm::rotate(model, glm::radians(p.RotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::scale(model, glm::vec3(p.Scale));
+
+        matrices[i] = model;
+    }
+}
+
+void computeBodyBounds(const CelestialBody* bodies, size_t count, float meshRadius, BoundingSphere* bounds) {
+    for (size_t i = 0; i < count; ++i) {
+        bounds[i].Center = bodies[i].Position;
+        bounds[i].Radius = meshRadius * bodies[i].Scale;
+    }
+}
+
+size_t packInstances(const View* views, int viewCount, const BoundingSphere* bounds, const glm::mat4* matrices,
+    size_t count, bool useImpostors, std::vector<glm::mat4>& meshInstances, std::vector<glm::mat4>& impostorInstances) {
+    size_t blended = 0;
+    meshInstances.clear();
+    impostorInstances.clear();
+
+    for (size_t i = 0; i < count; ++i) {
+        float size = getProjectedSize(views, viewCount, bounds[i].Center, bounds[i].Radius);
+        if (size <= 0.0f)
+            continue;
+
+        float fade = 0.0f;
+        if (useImpostors)
+            fade = glm::clamp((IMPOSTOR_BLEND_SIZE - size) / (IMPOSTOR_BLEND_SIZE - IMPOSTOR_SCREEN_SIZE), 0.0f, 1.0f);
+
+        glm::mat4 matrix = matrices[i];
+        matrix[0][3] = fade;
+        if (fade < 1.0f)
+            meshInstances.push_back(matrix);
+        if (fade > 0.0f)
+            impostorInstances.push_back(matrix);
+        if (fade > 0.0f && fade < 1.0f)
+            ++blended;
+    }
+    return blended;
+}
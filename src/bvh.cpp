@@ -0,0 +1,289 @@
+﻿#include "../headers/bvh.h"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+
+// Максимальное число примитивов в листе
+const uint32_t BVH_LEAF_SIZE = 4;
+
+// Во сколько раз стоимость дерева после refit может превысить исходную до перестройки
+const float BVH_REBUILD_RATIO = 1.5f;
+
+static AABB emptyBounds() {
+    const float inf = std::numeric_limits<float>::max();
+    AABB box;
+    box.Min = glm::vec3(inf);
+    box.Max = glm::vec3(-inf);
+    return box;
+}
+
+static void growBounds(AABB& box, const glm::vec3& p) {
+    box.Min = glm::min(box.Min, p);
+    box.Max = glm::max(box.Max, p);
+}
+
+static void growBounds(AABB& box, const AABB& other) {
+    box.Min = glm::min(box.Min, other.Min);
+    box.Max = glm::max(box.Max, other.Max);
+}
+
+static float surfaceArea(const AABB& box) {
+    glm::vec3 d = box.Max - box.Min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static int largestAxis(const AABB& box) {
+    glm::vec3 d = box.Max - box.Min;
+    if (d.x >= d.y && d.x >= d.z)
+        return 0;
+    return d.y >= d.z ? 1 : 2;
+}
+
+/**
+ * @brief Строит топологию дерева медианным разбиением по самой длинной оси центров.
+ * * boundsOf(index) возвращает рамку примитива, centerOf(index) — его центр.
+ */
+template <typename BoundsOf, typename CenterOf>
+static void buildNodes(std::vector<BVHNode>& nodes, std::vector<uint32_t>& indices, BoundsOf boundsOf, CenterOf centerOf) {
+    nodes.clear();
+    if (indices.empty()) {
+        return;
+    }
+    nodes.reserve(2 * (indices.size() / BVH_LEAF_SIZE + 1));
+
+    BVHNode root;
+    root.First = 0;
+    root.Count = static_cast<uint32_t>(indices.size());
+    nodes.push_back(root);
+
+    std::vector<uint32_t> pending;
+    pending.push_back(0);
+
+    while (!pending.empty()) {
+        uint32_t nodeIndex = pending.back();
+        pending.pop_back();
+
+        uint32_t first = nodes[nodeIndex].First;
+        uint32_t count = nodes[nodeIndex].Count;
+
+        AABB bounds = emptyBounds();
+        AABB centroidBounds = emptyBounds();
+        for (uint32_t i = first; i < first + count; ++i) {
+            growBounds(bounds, boundsOf(indices[i]));
+            growBounds(centroidBounds, centerOf(indices[i]));
+        }
+        nodes[nodeIndex].Bounds = bounds;
+
+        if (count <= BVH_LEAF_SIZE) {
+            continue;
+        }
+
+        int axis = largestAxis(centroidBounds);
+        uint32_t mid = first + count / 2;
+        std::nth_element(indices.begin() + first, indices.begin() + mid, indices.begin() + first + count,
+            [&](uint32_t a, uint32_t b) { return centerOf(a)[axis] < centerOf(b)[axis]; });
+
+        uint32_t left = static_cast<uint32_t>(nodes.size());
+        BVHNode child;
+        child.First = first;
+        child.Count = mid - first;
+        nodes.push_back(child);
+        child.First = mid;
+        child.Count = first + count - mid;
+        nodes.push_back(child);
+
+        nodes[nodeIndex].First = left;
+        nodes[nodeIndex].Count = 0;
+        pending.push_back(left);
+        pending.push_back(left + 1);
+    }
+}
+
+bool intersectRayAABB(const Ray& ray, const glm::vec3& invDir, const AABB& box, float tMax, float& tEnter) {
+    float tx1 = (box.Min.x - ray.Origin.x) * invDir.x;
+    float tx2 = (box.Max.x - ray.Origin.x) * invDir.x;
+    float tmin = std::min(tx1, tx2);
+    float tmax = std::max(tx1, tx2);
+
+    float ty1 = (box.Min.y - ray.Origin.y) * invDir.y;
+    float ty2 = (box.Max.y - ray.Origin.y) * invDir.y;
+    tmin = std::max(tmin, std::min(ty1, ty2));
+    tmax = std::min(tmax, std::max(ty1, ty2));
+
+    float tz1 = (box.Min.z - ray.Origin.z) * invDir.z;
+    float tz2 = (box.Max.z - ray.Origin.z) * invDir.z;
+    tmin = std::max(tmin, std::min(tz1, tz2));
+    tmax = std::min(tmax, std::max(tz1, tz2));
+
+    tEnter = std::max(tmin, 0.0f);
+    return tmax >= tEnter && tEnter <= tMax;
+}
+
+bool intersectRaySphere(const Ray& ray, const BoundingSphere& sphere, float& tEnter) {
+    glm::vec3 oc = ray.Origin - sphere.Center;
+    float a = glm::dot(ray.Direction, ray.Direction);
+    float b = glm::dot(oc, ray.Direction);
+    float c = glm::dot(oc, oc) - sphere.Radius * sphere.Radius;
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) {
+        return false;
+    }
+    float sqrtD = std::sqrt(discriminant);
+    float t0 = (-b - sqrtD) / a;
+    float t1 = (-b + sqrtD) / a;
+    if (t1 < 0.0f) {
+        return false;
+    }
+    tEnter = std::max(t0, 0.0f);
+    return true;
+}
+
+// --- InstanceBVH ---
+
+InstanceBVH::InstanceBVH() : m_spheres(nullptr), m_builtCost(0.0f) {
+}
+
+void InstanceBVH::update(const std::vector<BoundingSphere>& spheres) {
+    if (spheres.size() != m_indices.size() || spheres.data() != m_spheres || !refit(spheres)) {
+        build(spheres);
+    }
+}
+
+void InstanceBVH::build(const std::vector<BoundingSphere>& spheres) {
+    m_spheres = spheres.data();
+    m_indices.resize(spheres.size());
+    std::iota(m_indices.begin(), m_indices.end(), 0u);
+
+    buildNodes(m_nodes, m_indices,
+        [&](uint32_t i) {
+            AABB box;
+            box.Min = spheres[i].Center - glm::vec3(spheres[i].Radius);
+            box.Max = spheres[i].Center + glm::vec3(spheres[i].Radius);
+            return box;
+        },
+        [&](uint32_t i) { return spheres[i].Center; });
+
+    m_builtCost = computeCost();
+}
+
+bool InstanceBVH::refit(const std::vector<BoundingSphere>& spheres) {
+    m_spheres = spheres.data();
+
+    float cost = 0.0f;
+    for (size_t n = m_nodes.size(); n-- > 0;) {
+        BVHNode& node = m_nodes[n];
+        if (node.Count > 0) {
+            AABB box = emptyBounds();
+            for (uint32_t i = node.First; i < node.First + node.Count; ++i) {
+                const BoundingSphere& s = spheres[m_indices[i]];
+                growBounds(box, s.Center - glm::vec3(s.Radius));
+                growBounds(box, s.Center + glm::vec3(s.Radius));
+            }
+            node.Bounds = box;
+        }
+        else {
+            node.Bounds = m_nodes[node.First].Bounds;
+            growBounds(node.Bounds, m_nodes[node.First + 1].Bounds);
+        }
+        cost += surfaceArea(node.Bounds);
+    }
+
+    return m_nodes.empty() || cost <= m_builtCost * BVH_REBUILD_RATIO;
+}
+
+float InstanceBVH::computeCost() const {
+    float cost = 0.0f;
+    for (const BVHNode& node : m_nodes) {
+        cost += surfaceArea(node.Bounds);
+    }
+    return cost;
+}
+
+// --- TriangleBVH ---
+
+void TriangleBVH::build(const std::vector<glm::vec3>& positions) {
+    size_t triangleCount = positions.size() / 3;
+
+    std::vector<AABB> bounds(triangleCount);
+    std::vector<glm::vec3> centers(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        AABB box = emptyBounds();
+        growBounds(box, positions[t * 3 + 0]);
+        growBounds(box, positions[t * 3 + 1]);
+        growBounds(box, positions[t * 3 + 2]);
+        bounds[t] = box;
+        centers[t] = (box.Min + box.Max) * 0.5f;
+    }
+
+    std::vector<uint32_t> indices(triangleCount);
+    std::iota(indices.begin(), indices.end(), 0u);
+    buildNodes(m_nodes, indices,
+        [&](uint32_t i) { return bounds[i]; },
+        [&](uint32_t i) { return centers[i]; });
+
+    // Треугольники переупорядочиваются в порядке листьев, чтобы лист читал память подряд
+    m_triangles.resize(triangleCount);
+    for (size_t i = 0; i < triangleCount; ++i) {
+        uint32_t t = indices[i];
+        Triangle& tri = m_triangles[i];
+        tri.V0 = positions[t * 3 + 0];
+        tri.Edge1 = positions[t * 3 + 1] - tri.V0;
+        tri.Edge2 = positions[t * 3 + 2] - tri.V0;
+    }
+}
+
+bool TriangleBVH::intersect(const Ray& ray, float& tHit) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    glm::vec3 invDir(1.0f / ray.Direction.x, 1.0f / ray.Direction.y, 1.0f / ray.Direction.z);
+    bool hit = false;
+
+    uint32_t stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const BVHNode& node = m_nodes[stack[--stackSize]];
+        float tEnter;
+        if (!intersectRayAABB(ray, invDir, node.Bounds, tHit, tEnter)) {
+            continue;
+        }
+
+        if (node.Count == 0) {
+            stack[stackSize++] = node.First + 1;
+            stack[stackSize++] = node.First;
+            continue;
+        }
+
+        // Пересечение луча с треугольником (Möller–Trumbore), без отсечения задних граней
+        for (uint32_t i = node.First; i < node.First + node.Count; ++i) {
+            const Triangle& tri = m_triangles[i];
+            glm::vec3 p = glm::cross(ray.Direction, tri.Edge2);
+            float det = glm::dot(tri.Edge1, p);
+            if (std::fabs(det) < 1e-12f) {
+                continue;
+            }
+            float invDet = 1.0f / det;
+            glm::vec3 s = ray.Origin - tri.V0;
+            float u = glm::dot(s, p) * invDet;
+            if (u < 0.0f || u > 1.0f) {
+                continue;
+            }
+            glm::vec3 q = glm::cross(s, tri.Edge1);
+            float v = glm::dot(ray.Direction, q) * invDet;
+            if (v < 0.0f || u + v > 1.0f) {
+                continue;
+            }
+            float t = glm::dot(tri.Edge2, q) * invDet;
+            if (t > 0.0f && t < tHit) {
+                tHit = t;
+                hit = true;
+            }
+        }
+    }
+
+    return hit;
+}
@@ -0,0 +1,200 @@
+﻿#include "../headers/dynamic_resolution.h"
+#include "../headers/resource_tracker.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static const char* UPSCALE_VERTEX_SHADER_CODE = R"(
+#version 330 core
+out vec2 TexCoord;
+
+uniform vec2 uvScale;
+
+void main()
+{
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoord = pos * uvScale;
+    gl_ClipDistance[0] = 1.0;
+    gl_ClipDistance[1] = 1.0;
+    gl_ClipDistance[2] = 1.0;
+    gl_ClipDistance[3] = 1.0;
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+static const char* UPSCALE_FRAGMENT_SHADER_CODE = R"(
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D sceneColor;
+uniform vec2 texelSize;
+uniform vec2 uvMax;
+uniform float sharpness;
+
+vec3 sampleScene(vec2 uv)
+{
+    return texture(sceneColor, clamp(uv, 0.5 * texelSize, uvMax)).rgb;
+}
+
+void main()
+{
+    vec3 color = sampleScene(TexCoord);
+    if (sharpness > 0.0) {
+        vec3 blur = 0.25 * (sampleScene(TexCoord + vec2(texelSize.x, 0.0)) + sampleScene(TexCoord - vec2(texelSize.x, 0.0))
+            + sampleScene(TexCoord + vec2(0.0, texelSize.y)) + sampleScene(TexCoord - vec2(0.0, texelSize.y)));
+        color = clamp(color + (color - blur) * sharpness, 0.0, 1.0);
+    }
+    FragColor = vec4(color, 1.0);
+}
+)";
+
+// Сила нерезкого маскирования в режиме UPSCALE_SHARPEN
+const float UPSCALE_SHARPNESS = 0.5f;
+
+// Доля бюджета, в пределах которой масштаб не меняется (против колебаний)
+const float SCALE_DEADBAND = 0.1f;
+
+// Доля шага к расчётному масштабу: вниз быстро, вверх медленно
+const float SCALE_DOWN_RATE = 0.5f;
+const float SCALE_UP_RATE = 0.1f;
+
+DynamicResolution::DynamicResolution(float gpuBudgetMs, float minScale, float maxScale)
+    : m_budgetMs(gpuBudgetMs), m_minScale(minScale), m_maxScale(maxScale), m_scale(maxScale),
+      m_enabled(true), m_filter(UPSCALE_BILINEAR), m_windowWidth(0), m_windowHeight(0),
+      m_framebuffer(0), m_colorTexture(0), m_depthRenderbuffer(0), m_emptyVAO(0),
+      m_upscaleShader(UPSCALE_VERTEX_SHADER_CODE, UPSCALE_FRAGMENT_SHADER_CODE) {
+    glGenVertexArrays(1, &m_emptyVAO);
+
+    m_upscaleShader.use();
+    m_upscaleShader.setInt("sceneColor", 0);
+}
+
+DynamicResolution::~DynamicResolution() {
+    release();
+    glDeleteVertexArrays(1, &m_emptyVAO);
+}
+
+void DynamicResolution::release() {
+    ResourceTracker& tracker = ResourceTracker::instance();
+    if (m_framebuffer != 0) {
+        glDeleteFramebuffers(1, &m_framebuffer);
+        m_framebuffer = 0;
+    }
+    if (m_colorTexture != 0) {
+        tracker.release(RESOURCE_GPU_TEXTURE, m_colorTexture);
+        glDeleteTextures(1, &m_colorTexture);
+        m_colorTexture = 0;
+    }
+    if (m_depthRenderbuffer != 0) {
+        tracker.release(RESOURCE_GPU_TEXTURE, RESOURCE_RENDERBUFFER_TAG | m_depthRenderbuffer);
+        glDeleteRenderbuffers(1, &m_depthRenderbuffer);
+        m_depthRenderbuffer = 0;
+    }
+}
+
+void DynamicResolution::resize(int windowWidth, int windowHeight) {
+    release();
+    m_windowWidth = std::max(windowWidth, 1);
+    m_windowHeight = std::max(windowHeight, 1);
+
+    glGenTextures(1, &m_colorTexture);
+    glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_windowWidth, m_windowHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &m_depthRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_windowWidth, m_windowHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::DYNAMIC_RESOLUTION::RESIZE: Framebuffer is not complete, rendering at native resolution." << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        release();
+        return;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    size_t bytes = static_cast<size_t>(m_windowWidth) * m_windowHeight * 4;
+    ResourceTracker& tracker = ResourceTracker::instance();
+    tracker.setUsage(RESOURCE_GPU_TEXTURE, m_colorTexture, bytes, "dynamic resolution target (color)");
+    tracker.setUsage(RESOURCE_GPU_TEXTURE, RESOURCE_RENDERBUFFER_TAG | m_depthRenderbuffer, bytes, "dynamic resolution target (depth)");
+}
+
+void DynamicResolution::setEnabled(bool enabled) {
+    m_enabled = enabled;
+    m_timer.reset();
+}
+
+int DynamicResolution::getRenderWidth() const {
+    return std::max(static_cast<int>(std::lround(m_windowWidth * getScale())), 1);
+}
+
+int DynamicResolution::getRenderHeight() const {
+    return std::max(static_cast<int>(std::lround(m_windowHeight * getScale())), 1);
+}
+
+void DynamicResolution::beginFrame() {
+    bool offscreen = m_enabled && m_framebuffer != 0;
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreen ? m_framebuffer : 0);
+    m_timer.begin();
+}
+
+void DynamicResolution::endFrame() {
+    m_timer.end();
+    updateScale();
+
+    if (!m_enabled || m_framebuffer == 0) {
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, m_windowWidth, m_windowHeight);
+    glDisable(GL_DEPTH_TEST);
+
+    float scaleX = static_cast<float>(getRenderWidth()) / m_windowWidth;
+    float scaleY = static_cast<float>(getRenderHeight()) / m_windowHeight;
+    glm::vec2 texelSize(1.0f / m_windowWidth, 1.0f / m_windowHeight);
+
+    m_upscaleShader.use();
+    m_upscaleShader.setVec2("uvScale", glm::vec2(scaleX, scaleY));
+    m_upscaleShader.setVec2("texelSize", texelSize);
+    // Не выходить за нарисованный прямоугольник, иначе по краю подмешивается мусор
+    m_upscaleShader.setVec2("uvMax", glm::vec2(scaleX - 0.5f * texelSize.x, scaleY - 0.5f * texelSize.y));
+    m_upscaleShader.setFloat("sharpness", m_filter == UPSCALE_SHARPEN ? UPSCALE_SHARPNESS : 0.0f);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+    glBindVertexArray(m_emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+void DynamicResolution::updateScale() {
+    if (!m_timer.poll() || !m_enabled || m_framebuffer == 0) {
+        return;
+    }
+
+    double gpuMs = std::max(m_timer.getLastMs(), 0.01);
+    double ratio = m_budgetMs / gpuMs;
+    if (ratio >= 1.0 && ratio <= 1.0 + SCALE_DEADBAND) {
+        return;
+    }
+
+    float target = m_scale * static_cast<float>(std::sqrt(ratio));
+    float rate = target < m_scale ? SCALE_DOWN_RATE : SCALE_UP_RATE;
+    m_scale = std::min(std::max(m_scale + (target - m_scale) * rate, m_minScale), m_maxScale);
+}
@@ -0,0 +1,272 @@
+﻿#include "../headers/frame_capture.h"
+#include "../headers/resource_tracker.h"
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+// Максимум кадров, ожидающих записи на диск; сверх этого кадры пропускаются
+const size_t MAX_QUEUED_FRAMES = 8;
+
+FrameCapture::FrameCapture(GLuint width, GLuint height, const std::string& outputPath, Capture_Format format, int fps, int ringSize)
+    : m_width(width), m_height(height), m_outputPath(outputPath), m_format(format), m_fps(fps),
+    m_head(0), m_inFlight(0), m_capturedFrames(0), m_droppedFrames(0), m_writtenFrames(0),
+    m_allocatedFrames(0), m_stopping(false) {
+
+    size_t frameSize = static_cast<size_t>(m_width) * m_height * 4;
+
+    m_slots.resize(ringSize < 2 ? 2 : ringSize);
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+        ResourceTracker::instance().setUsage(RESOURCE_GPU_BUFFER, slot.pbo, frameSize, "frame capture PBO");
+        slot.fence = 0;
+        slot.frameIndex = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (m_format == CAPTURE_Y4M) {
+        m_y4mFile.open(m_outputPath, std::ios::binary | std::ios::trunc);
+        if (!m_y4mFile.is_open()) {
+            std::cerr << "ERROR::CAPTURE::OPEN: Failed to open file for writing: " << m_outputPath << std::endl;
+        }
+        else {
+            m_y4mFile << "YUV4MPEG2 W" << m_width << " H" << m_height << " F" << m_fps << ":1 Ip A1:1 C420jpeg\n";
+        }
+    }
+
+    m_writer = std::thread(&FrameCapture::writerLoop, this);
+
+    std::cout << "Capture started: " << m_width << "x" << m_height << " -> " << m_outputPath << std::endl;
+}
+
+FrameCapture::~FrameCapture() {
+    // Дочитываем все кадры, которые ещё в полёте
+    while (m_inFlight > 0) {
+        Slot& tail = m_slots[(m_head + m_slots.size() - m_inFlight) % m_slots.size()];
+        retireSlot(tail, true);
+        --m_inFlight;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_queueChanged.notify_all();
+    m_writer.join();
+
+    for (Slot& slot : m_slots) {
+        ResourceTracker::instance().release(RESOURCE_GPU_BUFFER, slot.pbo);
+        glDeleteBuffers(1, &slot.pbo);
+    }
+    for (Frame* frame : m_freeFrames) {
+        delete frame;
+    }
+
+    std::cout << "Capture finished: " << m_writtenFrames.load() << " frames written, " << m_droppedFrames
+        << " dropped -> " << m_outputPath << std::endl;
+}
+
+void FrameCapture::captureFrame() {
+    // Забираем готовые кадры по порядку, не блокируясь
+    while (m_inFlight > 0) {
+        Slot& tail = m_slots[(m_head + m_slots.size() - m_inFlight) % m_slots.size()];
+        if (!retireSlot(tail, false)) {
+            break;
+        }
+        --m_inFlight;
+    }
+
+    // Кольцо заполнено: GPU отстал больше чем на размер кольца, придётся подождать
+    if (m_inFlight == m_slots.size()) {
+        retireSlot(m_slots[m_head], true);
+        --m_inFlight;
+    }
+
+    Slot& slot = m_slots[m_head];
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glReadBuffer(GL_BACK);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frameIndex = m_capturedFrames++;
+
+    m_head = (m_head + 1) % m_slots.size();
+    ++m_inFlight;
+}
+
+bool FrameCapture::retireSlot(Slot& slot, bool wait) {
+    GLenum status;
+    if (wait) {
+        do {
+            status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    else {
+        status = glClientWaitSync(slot.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            return false;
+        }
+    }
+
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+
+    if (status == GL_WAIT_FAILED) {
+        std::cerr << "ERROR::CAPTURE::SYNC: glClientWaitSync failed for frame " << slot.frameIndex << std::endl;
+        ++m_droppedFrames;
+        return true;
+    }
+
+    Frame* frame = acquireFrame();
+    if (frame == nullptr) {
+        ++m_droppedFrames;
+        return true;
+    }
+
+    size_t frameSize = static_cast<size_t>(m_width) * m_height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+    if (data) {
+        std::memcpy(frame->pixels.data(), data, frameSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (!data) {
+        std::cerr << "ERROR::CAPTURE::MAP: Failed to map pixel buffer for frame " << slot.frameIndex << std::endl;
+        releaseFrame(frame);
+        ++m_droppedFrames;
+        return true;
+    }
+
+    frame->frameIndex = slot.frameIndex;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(frame);
+    }
+    m_queueChanged.notify_one();
+    return true;
+}
+
+FrameCapture::Frame* FrameCapture::acquireFrame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_freeFrames.empty()) {
+        Frame* frame = m_freeFrames.back();
+        m_freeFrames.pop_back();
+        return frame;
+    }
+    if (m_allocatedFrames >= MAX_QUEUED_FRAMES) {
+        return nullptr;
+    }
+    ++m_allocatedFrames;
+    Frame* frame = new Frame();
+    frame->pixels.resize(static_cast<size_t>(m_width) * m_height * 4);
+    return frame;
+}
+
+void FrameCapture::releaseFrame(Frame* frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_freeFrames.push_back(frame);
+}
+
+void FrameCapture::writerLoop() {
+    std::vector<unsigned char> scratch;
+
+    while (true) {
+        Frame* frame = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queueChanged.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            frame = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        if (m_format == CAPTURE_Y4M) {
+            writeY4MFrame(*frame, scratch);
+        }
+        else {
+            writePPMFrame(*frame, scratch);
+        }
+
+        releaseFrame(frame);
+        ++m_writtenFrames;
+    }
+}
+
+void FrameCapture::writeY4MFrame(const Frame& frame, std::vector<unsigned char>& yuv) {
+    if (!m_y4mFile.is_open()) {
+        return;
+    }
+
+    const size_t w = m_width;
+    const size_t h = m_height;
+    const size_t cw = (w + 1) / 2;
+    const size_t ch = (h + 1) / 2;
+    yuv.resize(w * h + 2 * cw * ch);
+
+    unsigned char* yPlane = yuv.data();
+    unsigned char* uPlane = yPlane + w * h;
+    unsigned char* vPlane = uPlane + cw * ch;
+    const unsigned char* src = frame.pixels.data();
+
+    // BT.601, ограниченный диапазон; строки OpenGL идут снизу вверх
+    for (size_t y = 0; y < h; ++y) {
+        const unsigned char* row = src + (h - 1 - y) * w * 4;
+        for (size_t x = 0; x < w; ++x) {
+            int r = row[x * 4 + 0], g = row[x * 4 + 1], b = row[x * 4 + 2];
+            yPlane[y * w + x] = static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+
+    for (size_t cy = 0; cy < ch; ++cy) {
+        size_t y0 = cy * 2;
+        size_t y1 = y0 + 1 < h ? y0 + 1 : y0;
+        const unsigned char* row0 = src + (h - 1 - y0) * w * 4;
+        const unsigned char* row1 = src + (h - 1 - y1) * w * 4;
+        for (size_t cx = 0; cx < cw; ++cx) {
+            size_t x0 = cx * 2;
+            size_t x1 = x0 + 1 < w ? x0 + 1 : x0;
+            int r = (row0[x0 * 4 + 0] + row0[x1 * 4 + 0] + row1[x0 * 4 + 0] + row1[x1 * 4 + 0] + 2) >> 2;
+            int g = (row0[x0 * 4 + 1] + row0[x1 * 4 + 1] + row1[x0 * 4 + 1] + row1[x1 * 4 + 1] + 2) >> 2;
+            int b = (row0[x0 * 4 + 2] + row0[x1 * 4 + 2] + row1[x0 * 4 + 2] + row1[x1 * 4 + 2] + 2) >> 2;
+            uPlane[cy * cw + cx] = static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[cy * cw + cx] = static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+
+    m_y4mFile << "FRAME\n";
+    m_y4mFile.write(reinterpret_cast<const char*>(yuv.data()), yuv.size());
+}
+
+void FrameCapture::writePPMFrame(const Frame& frame, std::vector<unsigned char>& rgb) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "_%06llu.ppm", static_cast<unsigned long long>(frame.frameIndex));
+
+    std::ofstream file(m_outputPath + suffix, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::CAPTURE::WRITE: Failed to open file for writing: " << m_outputPath + suffix << std::endl;
+        return;
+    }
+
+    const size_t w = m_width;
+    const size_t h = m_height;
+    rgb.resize(w * h * 3);
+    for (size_t y = 0; y < h; ++y) {
+        const unsigned char* row = frame.pixels.data() + (h - 1 - y) * w * 4;
+        unsigned char* dst = rgb.data() + y * w * 3;
+        for (size_t x = 0; x < w; ++x) {
+            dst[x * 3 + 0] = row[x * 4 + 0];
+            dst[x * 3 + 1] = row[x * 4 + 1];
+            dst[x * 3 + 2] = row[x * 4 + 2];
+        }
+    }
+
+    file << "P6\n" << w << " " << h << "\n255\n";
+    file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+}
@@ -0,0 +1,117 @@
+﻿#include "../headers/frame_pacer.h"
+#include <thread>
+#include <cmath>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+FramePacer::FramePacer(float targetFps, float spinThresholdMs)
+    : m_hasPresent(false) {
+    m_targetFrameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+    m_spinThreshold = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(spinThresholdMs));
+
+#ifdef _WIN32
+    // Без этого Sleep на Windows имеет точность ~15.6 мс
+    timeBeginPeriod(1);
+#endif
+
+    Clock::time_point now = Clock::now();
+    m_nextFrame = now;
+    m_lastFrameStart = now;
+    m_inputSampled = now;
+    m_lastPresent = now;
+    m_lastReport = now;
+    resetStats();
+}
+
+FramePacer::~FramePacer() {
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+}
+
+float FramePacer::waitForNextFrame() {
+    Clock::time_point now = Clock::now();
+
+    if (m_nextFrame - now > m_spinThreshold) {
+        std::this_thread::sleep_for(m_nextFrame - now - m_spinThreshold);
+    }
+    while (Clock::now() < m_nextFrame) {
+        std::this_thread::yield();
+    }
+
+    now = Clock::now();
+    // Если кадр опоздал больше чем на период, сетка сдвигается, а не пытается догнать
+    if (now - m_nextFrame > m_targetFrameTime)
+        m_nextFrame = now + m_targetFrameTime;
+    else
+        m_nextFrame += m_targetFrameTime;
+
+    float deltaTime = std::chrono::duration<float>(now - m_lastFrameStart).count();
+    m_lastFrameStart = now;
+    return deltaTime;
+}
+
+void FramePacer::markInputSampled() {
+    m_inputSampled = Clock::now();
+}
+
+void FramePacer::markPresented() {
+    Clock::time_point now = Clock::now();
+
+    double latency = std::chrono::duration<double, std::milli>(now - m_inputSampled).count();
+    ++m_latencySamples;
+    m_latencySum += latency;
+    m_latencyMax = std::max(m_latencyMax, latency);
+
+    if (m_hasPresent) {
+        double frameMs = std::chrono::duration<double, std::milli>(now - m_lastPresent).count();
+        ++m_frames;
+        double delta = frameMs - m_frameMean;
+        m_frameMean += delta / m_frames;
+        m_frameM2 += delta * (frameMs - m_frameMean);
+        m_frameMax = std::max(m_frameMax, frameMs);
+    }
+    m_lastPresent = now;
+    m_hasPresent = true;
+}
+
+FramePacer::Stats FramePacer::getStats() const {
+    Stats stats;
+    stats.Frames = m_frames;
+    stats.MeanFrameMs = m_frameMean;
+    stats.FrameStdDevMs = m_frames > 1 ? std::sqrt(m_frameM2 / (m_frames - 1)) : 0.0;
+    stats.MaxFrameMs = m_frameMax;
+    stats.MeanLatencyMs = m_latencySamples > 0 ? m_latencySum / m_latencySamples : 0.0;
+    stats.MaxLatencyMs = m_latencyMax;
+    return stats;
+}
+
+void FramePacer::resetStats() {
+    m_frames = 0;
+    m_frameMean = 0.0;
+    m_frameM2 = 0.0;
+    m_frameMax = 0.0;
+    m_latencySamples = 0;
+    m_latencySum = 0.0;
+    m_latencyMax = 0.0;
+}
+
+void FramePacer::reportEvery(float intervalSeconds, std::ostream& out) {
+    Clock::time_point now = Clock::now();
+    if (std::chrono::duration<float>(now - m_lastReport).count() < intervalSeconds)
+        return;
+    m_lastReport = now;
+
+    Stats stats = getStats();
+    out << "Frame pacing: " << stats.Frames << " frames, avg " << stats.MeanFrameMs << " ms, stddev "
+        << stats.FrameStdDevMs << " ms, max " << stats.MaxFrameMs << " ms; input->present avg "
+        << stats.MeanLatencyMs << " ms, max " << stats.MaxLatencyMs << " ms" << std::endl;
+    resetStats();
+}
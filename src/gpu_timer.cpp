@@ -0,0 +1,79 @@
+﻿#include "../headers/gpu_timer.h"
+
+GpuTimer::GpuTimer()
+    : m_next(0), m_active(false), m_discard(0), m_lastMs(0.0), m_totalMs(0.0), m_samples(0) {
+    glGenQueries(2 * RING_SIZE, &m_queries[0][0]);
+    for (int i = 0; i < RING_SIZE; ++i) {
+        m_pending[i] = false;
+    }
+}
+
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(2 * RING_SIZE, &m_queries[0][0]);
+}
+
+void GpuTimer::begin() {
+    poll();
+    if (m_active || m_pending[m_next]) {
+        return;
+    }
+    glQueryCounter(m_queries[m_next][0], GL_TIMESTAMP);
+    m_active = true;
+}
+
+void GpuTimer::end() {
+    if (!m_active) {
+        return;
+    }
+    glQueryCounter(m_queries[m_next][1], GL_TIMESTAMP);
+    m_active = false;
+    m_pending[m_next] = true;
+    m_next = (m_next + 1) % RING_SIZE;
+}
+
+bool GpuTimer::poll(bool wait) {
+    bool updated = false;
+
+    // Запросы завершаются по порядку, поэтому проверяем от самого старого
+    for (int i = 0; i < RING_SIZE; ++i) {
+        int index = (m_next + i) % RING_SIZE;
+        if (!m_pending[index]) {
+            continue;
+        }
+        if (!wait) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(m_queries[index][1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+        }
+
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(m_queries[index][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(m_queries[index][1], GL_QUERY_RESULT, &end);
+        m_pending[index] = false;
+
+        if (m_discard > 0) {
+            --m_discard;
+            continue;
+        }
+        m_lastMs = static_cast<double>(end - start) / 1.0e6;
+        m_totalMs += m_lastMs;
+        ++m_samples;
+        updated = true;
+    }
+    return updated;
+}
+
+void GpuTimer::reset() {
+    m_discard = 0;
+    for (int i = 0; i < RING_SIZE; ++i) {
+        if (m_pending[i])
+            ++m_discard;
+    }
+    if (m_active)
+        ++m_discard;
+    m_lastMs = 0.0;
+    m_totalMs = 0.0;
+    m_samples = 0;
+}
@@ -0,0 +1,327 @@
+﻿#include "../headers/impostor.h"
+#include "../headers/resource_tracker.h"
+#include <cmath>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+
+static const char* IMPOSTOR_VERTEX_SHADER_CODE = R"(
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 2) in mat4 instanceModel;
+
+out vec2 AtlasCoord;
+out vec3 WorldPos;
+flat out vec3 DepthAxis;
+flat out float Fade;
+flat out int ViewIndex;
+
+const int MAX_VIEWS = 4;
+
+uniform mat4 viewProjections[MAX_VIEWS];
+uniform vec4 viewRects[MAX_VIEWS];
+uniform vec4 viewPositions[MAX_VIEWS];
+uniform int viewCount;
+uniform int framesPerSide;
+uniform float boundingRadius;
+
+vec2 signNotZero(vec2 v)
+{
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 octahedralEncode(vec3 d)
+{
+    d /= abs(d.x) + abs(d.y) + abs(d.z);
+    vec2 uv = d.xz;
+    if (d.y < 0.0)
+        uv = (1.0 - abs(uv.yx)) * signNotZero(uv);
+    return uv;
+}
+
+vec3 octahedralDecode(vec2 uv)
+{
+    vec3 d = vec3(uv.x, 1.0 - abs(uv.x) - abs(uv.y), uv.y);
+    if (d.y < 0.0)
+        d.xz = (1.0 - abs(d.zx)) * signNotZero(d.xz);
+    return normalize(d);
+}
+
+void main()
+{
+    int viewIndex = gl_InstanceID % viewCount;
+    mat4 modelMatrix = instanceModel;
+    Fade = modelMatrix[0][3];
+    modelMatrix[0][3] = 0.0;
+
+    mat3 basis = mat3(modelMatrix);
+    vec3 toViewer = transpose(basis) * (viewPositions[viewIndex].xyz - modelMatrix[3].xyz);
+    vec2 grid = (octahedralEncode(normalize(toViewer)) * 0.5 + 0.5) * float(framesPerSide);
+    vec2 cell = clamp(floor(grid), 0.0, float(framesPerSide - 1));
+    vec3 frameDir = octahedralDecode((cell + 0.5) / float(framesPerSide) * 2.0 - 1.0);
+
+    vec3 upRef = abs(frameDir.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(upRef, frameDir));
+    vec3 up = cross(frameDir, right);
+
+    vec4 worldPos = modelMatrix * vec4((aCorner.x * right + aCorner.y * up) * boundingRadius, 1.0);
+    WorldPos = worldPos.xyz;
+    DepthAxis = basis * (-frameDir * 2.0 * boundingRadius);
+    AtlasCoord = (cell + aCorner * 0.5 + 0.5) / float(framesPerSide);
+    ViewIndex = viewIndex;
+
+    vec4 clipPos = viewProjections[viewIndex] * worldPos;
+    gl_ClipDistance[0] = clipPos.w + clipPos.x;
+    gl_ClipDistance[1] = clipPos.w - clipPos.x;
+    gl_ClipDistance[2] = clipPos.w + clipPos.y;
+    gl_ClipDistance[3] = clipPos.w - clipPos.y;
+
+    vec4 rect = viewRects[viewIndex];
+    clipPos.xy = clipPos.xy * rect.zw + rect.xy * clipPos.w;
+    gl_Position = clipPos;
+}
+)";
+
+static const char* IMPOSTOR_FRAGMENT_SHADER_CODE = R"(
+#version 330 core
+out vec4 FragColor;
+
+in vec2 AtlasCoord;
+in vec3 WorldPos;
+flat in vec3 DepthAxis;
+flat in float Fade;
+flat in int ViewIndex;
+
+const int MAX_VIEWS = 4;
+
+uniform mat4 viewProjections[MAX_VIEWS];
+uniform sampler2D impostorColor;
+uniform sampler2D impostorDepth;
+
+const float BAYER[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+
+void main()
+{
+    ivec2 cell = ivec2(gl_FragCoord.xy) & 3;
+    vec4 color = texture(impostorColor, AtlasCoord);
+    if (color.a < 0.5 || (BAYER[cell.y * 4 + cell.x] + 0.5) / 16.0 >= Fade)
+        discard;
+
+    float depth = texture(impostorDepth, AtlasCoord).r;
+    vec4 clipPos = viewProjections[ViewIndex] * vec4(WorldPos + DepthAxis * (depth - 0.5), 1.0);
+    gl_FragDepth = clipPos.z / clipPos.w * 0.5 + 0.5;
+    FragColor = vec4(color.rgb / color.a, 1.0);
+}
+)";
+
+// Сколько уровней атласа строить: на более грубых соседние ракурсы смешиваются
+const int IMPOSTOR_MAX_MIP_LEVEL = 2;
+
+// --- ImpostorAtlas ---
+
+ImpostorAtlas::ImpostorAtlas()
+    : m_colorTexture(0), m_depthTexture(0), m_framesPerSide(0), m_atlasSize(0), m_boundingRadius(0.0f) {
+}
+
+ImpostorAtlas::~ImpostorAtlas() {
+    release();
+}
+
+void ImpostorAtlas::release() {
+    ResourceTracker& tracker = ResourceTracker::instance();
+    if (m_colorTexture != 0) {
+        tracker.release(RESOURCE_GPU_TEXTURE, m_colorTexture);
+        glDeleteTextures(1, &m_colorTexture);
+        m_colorTexture = 0;
+    }
+    if (m_depthTexture != 0) {
+        tracker.release(RESOURCE_GPU_TEXTURE, m_depthTexture);
+        glDeleteTextures(1, &m_depthTexture);
+        m_depthTexture = 0;
+    }
+}
+
+glm::vec3 ImpostorAtlas::octahedralDecode(const glm::vec2& uv) {
+    glm::vec3 d(uv.x, 1.0f - std::fabs(uv.x) - std::fabs(uv.y), uv.y);
+    if (d.y < 0.0f) {
+        float x = (1.0f - std::fabs(d.z)) * (d.x >= 0.0f ? 1.0f : -1.0f);
+        float z = (1.0f - std::fabs(d.x)) * (d.z >= 0.0f ? 1.0f : -1.0f);
+        d.x = x;
+        d.z = z;
+    }
+    return glm::normalize(d);
+}
+
+bool ImpostorAtlas::bake(Shader& shader, Model& model, Texture* texture, int framesPerSide, int frameSize) {
+    release();
+    m_framesPerSide = framesPerSide;
+    m_atlasSize = framesPerSide * frameSize;
+    m_boundingRadius = model.getBoundingRadius();
+
+    GLint previousViewport[4];
+    GLint previousFramebuffer = 0;
+    GLfloat previousClearColor[4];
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClearColor);
+
+    glGenTextures(1, &m_colorTexture);
+    glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_atlasSize, m_atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, IMPOSTOR_MAX_MIP_LEVEL);
+
+    glGenTextures(1, &m_depthTexture);
+    glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_atlasSize, m_atlasSize, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete) {
+        std::cerr << "ERROR::IMPOSTOR::BAKE: Framebuffer is not complete." << std::endl;
+    }
+    else {
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        shader.use();
+        shader.setBool("useInstanceMatrix", false);
+        shader.setMat4("model", glm::mat4(1.0f));
+        shader.setInt("viewCount", 1);
+        shader.setVec4("viewRects[0]", glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+        if (texture) {
+            texture->bind(0);
+        }
+
+        // Камера ячейки - на расстоянии 2R, глубина [R, 3R] покрывает сферу целиком
+        float r = m_boundingRadius;
+        glm::mat4 projection = glm::ortho(-r, r, -r, r, r, 3.0f * r);
+        for (int y = 0; y < framesPerSide; ++y) {
+            for (int x = 0; x < framesPerSide; ++x) {
+                glm::vec2 uv((x + 0.5f) / framesPerSide * 2.0f - 1.0f, (y + 0.5f) / framesPerSide * 2.0f - 1.0f);
+                glm::vec3 direction = octahedralDecode(uv);
+                glm::vec3 up = std::fabs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                glm::mat4 view = glm::lookAt(direction * 2.0f * r, glm::vec3(0.0f), up);
+
+                glViewport(x * frameSize, y * frameSize, frameSize, frameSize);
+                shader.setMat4("viewProjections[0]", projection * view);
+                model.draw();
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+    glDeleteFramebuffers(1, &framebuffer);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    glClearColor(previousClearColor[0], previousClearColor[1], previousClearColor[2], previousClearColor[3]);
+
+    if (!complete) {
+        release();
+        return false;
+    }
+
+    // Цвет с mip-уровнями (примерно 4/3 от базового) и 32-битная глубина
+    size_t pixels = static_cast<size_t>(m_atlasSize) * m_atlasSize;
+    ResourceTracker& tracker = ResourceTracker::instance();
+    tracker.setUsage(RESOURCE_GPU_TEXTURE, m_colorTexture, pixels * 4 * 4 / 3, "impostor atlas (color)");
+    tracker.setUsage(RESOURCE_GPU_TEXTURE, m_depthTexture, pixels * 4, "impostor atlas (depth)");
+
+    std::cout << "Impostor atlas baked: " << framesPerSide << "x" << framesPerSide << " views of "
+        << frameSize << "px (" << m_atlasSize << "x" << m_atlasSize << ")" << std::endl;
+    return true;
+}
+
+void ImpostorAtlas::bind(GLuint colorUnit, GLuint depthUnit) const {
+    glActiveTexture(GL_TEXTURE0 + colorUnit);
+    glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+    glActiveTexture(GL_TEXTURE0 + depthUnit);
+    glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+// --- ImpostorRenderer ---
+
+ImpostorRenderer::ImpostorRenderer()
+    : m_shader(IMPOSTOR_VERTEX_SHADER_CODE, IMPOSTOR_FRAGMENT_SHADER_CODE), m_instanceVBO(0) {
+    const float corners[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+        -1.0f,  1.0f,
+         1.0f,  1.0f
+    };
+
+    glGenVertexArrays(1, &m_quadVAO);
+    glGenBuffers(1, &m_quadVBO);
+    glGenBuffers(1, &m_instanceVBO);
+
+    glBindVertexArray(m_quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    for (int i = 0; i < 4; ++i) {
+        glEnableVertexAttribArray(2 + i);
+        glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    ResourceTracker::instance().setUsage(RESOURCE_GPU_BUFFER, m_quadVBO, sizeof(corners), "impostor quad");
+
+    m_shader.use();
+    m_shader.setInt("impostorColor", 0);
+    m_shader.setInt("impostorDepth", 1);
+}
+
+ImpostorRenderer::~ImpostorRenderer() {
+    ResourceTracker& tracker = ResourceTracker::instance();
+    tracker.release(RESOURCE_GPU_BUFFER, m_quadVBO);
+    tracker.release(RESOURCE_GPU_BUFFER, m_instanceVBO);
+
+    glDeleteVertexArrays(1, &m_quadVAO);
+    glDeleteBuffers(1, &m_quadVBO);
+    glDeleteBuffers(1, &m_instanceVBO);
+}
+
+void ImpostorRenderer::draw(const MultiView& views, const ImpostorAtlas& atlas, const std::vector<glm::mat4>& instances) {
+    if (instances.empty() || !atlas.isBaked()) {
+        return;
+    }
+    GLuint viewCount = static_cast<GLuint>(views.getViewCount());
+
+    m_shader.use();
+    views.apply(m_shader);
+    m_shader.setInt("framesPerSide", atlas.getFramesPerSide());
+    m_shader.setFloat("boundingRadius", atlas.getBoundingRadius());
+    atlas.bind(0, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::mat4), instances.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ResourceTracker::instance().setUsage(RESOURCE_GPU_BUFFER, m_instanceVBO, instances.size() * sizeof(glm::mat4), "impostor instances");
+
+    glBindVertexArray(m_quadVAO);
+    for (int i = 0; i < 4; ++i) {
+        glVertexAttribDivisor(2 + i, viewCount);
+    }
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instances.size() * viewCount));
+    glBindVertexArray(0);
+}
@@ -5,36 +5,65 @@
 #include "../headers/model.h"
 #include "../headers/camera.h"
 #include "../headers/solar_system.h"
+#include "../headers/scene.h"
+#include "../headers/frame_capture.h"
+#include "../headers/frame_pacer.h"
+#include "../headers/resource_tracker.h"
+#include "../headers/texture_streamer.h"
+#include "../headers/multi_view.h"
+#include "../headers/dynamic_resolution.h"
+#include "../headers/meshlet.h"
+#include "../headers/obj_loader.h"
 
 #include <GL/glew.h>
 #include <SFML/Window.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <SFML/Graphics.hpp>
+#include <string>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
 
 const GLuint SCR_WIDTH = 1280;
 const GLuint SCR_HEIGHT = 720;
+const float TARGET_FPS = 60.0f;
+const int MULTI_VIEW_BENCHMARK_FRAMES = 240; // Кадров на каждый способ рисования
+// Бюджет GPU на сцену: кадр 60 FPS с запасом на увеличение изображения и представление
+const float GPU_SCENE_BUDGET_MS = 12.0f;
+const float TITLE_UPDATE_INTERVAL = 0.5f;    // Секунд между обновлениями заголовка окна
+
+// Бюджеты памяти ресурсов
+const size_t GPU_BUFFER_BUDGET = 256u * 1024u * 1024u;
+const size_t GPU_TEXTURE_BUDGET = 512u * 1024u * 1024u;
+const size_t CPU_MESH_BUDGET = 128u * 1024u * 1024u;
+const size_t TEXTURE_STREAMING_BUDGET = 256u * 1024u * 1024u;
 
 Camera camera(glm::vec3(0.0f, 0.0f, 150.0f));
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 float deltaTime = 0.0f;
-float lastFrame = 0.0f;
 
+GLuint windowWidth = SCR_WIDTH;
+GLuint windowHeight = SCR_HEIGHT;
+int captureCount = 0;
 
-void processInput(sf::Keyboard::Key key, float dt) {
-    if (key == sf::Keyboard::W)
+
+// Состояние клавиш опрашивается каждый кадр, а не по событиям KeyPressed,
+// поэтому движение непрерывное и не зависит от автоповтора клавиатуры
+void processInput(float dt) {
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
         camera.processKeyboard(FORWARD, dt);
-    if (key == sf::Keyboard::S)
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
         camera.processKeyboard(BACKWARD, dt);
-    if (key == sf::Keyboard::E)
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
         camera.processKeyboard(UP, dt);
-    if (key == sf::Keyboard::Q)
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
         camera.processKeyboard(DOWN, dt);
-    if (key == sf::Keyboard::A)
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
         camera.processKeyboard(LEFT, dt);
-    if (key == sf::Keyboard::D)
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
         camera.processKeyboard(RIGHT, dt);
 }
 
@@ -59,7 +88,59 @@ void updateMouseMovement(sf::RenderWindow& window, float xCenter, float yCenter)
     lastY = yCenter;
 }
 
-int main() {
+// Масштаб разрешения и время GPU в заголовке окна для диагностики
+std::string formatWindowTitle(const DynamicResolution& resolution) {
+    std::ostringstream title;
+    title << std::fixed << std::setprecision(2) << "Lab13 | ";
+    if (resolution.isEnabled()) {
+        title << "render scale " << static_cast<int>(resolution.getScale() * 100.0f + 0.5f) << "% ("
+            << resolution.getRenderWidth() << "x" << resolution.getRenderHeight() << ", "
+            << (resolution.getFilter() == UPSCALE_SHARPEN ? "sharpen" : "bilinear") << ")";
+    }
+    else {
+        title << "native resolution";
+    }
+    title << " | GPU " << resolution.getLastGpuMs() << " / " << resolution.getBudgetMs() << " ms";
+    return title.str();
+}
+
+int compileScene(const char* sourcePath, const char* outputPath) {
+    Scene scene;
+    if (!scene.load(sourcePath) || !scene.saveBinary(outputPath)) {
+        return -1;
+    }
+    std::cout << "Compiled scene '" << sourcePath << "' -> '" << outputPath << "' (" << scene.getBodyCount() << " bodies)" << std::endl;
+    return 0;
+}
+
+int buildMeshlets(const char* modelPath, const char* outputPath) {
+    std::vector<Vertex> vertices;
+    MeshletMesh mesh;
+    if (!loadObj(modelPath, vertices) || !mesh.build(vertices) || !mesh.save(outputPath)) {
+        return -1;
+    }
+    std::cout << "Built meshlets '" << modelPath << "' -> '" << outputPath << "' (" << mesh.getMeshlets().size()
+        << " clusters, cone culling " << (mesh.isConeCullingAllowed() ? "enabled" : "disabled: mesh is not closed") << ")" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::string(argv[1]) == "--compile-scene") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " --compile-scene <scene.scene> <scene.sceneb>" << std::endl;
+            return -1;
+        }
+        return compileScene(argv[2], argv[3]);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--build-meshlets") {
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " --build-meshlets <model.obj> [model.meshlets]" << std::endl;
+            return -1;
+        }
+        return buildMeshlets(argv[2], argc >= 4 ? argv[3] : getMeshletPath(argv[2]).c_str());
+    }
+    const char* scenePath = argc >= 2 ? argv[1] : "scenes/solar_system.scene";
+
     sf::ContextSettings settings;
     settings.depthBits = 24;
     settings.stencilBits = 8;
@@ -69,7 +150,8 @@ int main() {
 
     sf::RenderWindow window(sf::VideoMode(SCR_WIDTH, SCR_HEIGHT), "Lab13", sf::Style::Default, settings);
     window.setMouseCursorVisible(false);
-    window.setFramerateLimit(60);
+    // Частоту кадров держит FramePacer, а не setFramerateLimit/vsync
+    window.setVerticalSyncEnabled(false);
 
     glewExperimental = GL_TRUE;
     if (glewInit() != GLEW_OK) {
@@ -79,28 +161,51 @@ int main() {
 
     glEnable(GL_DEPTH_TEST);
     glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    // Границы прямоугольников видов при рисовании в несколько видов за проход
+    for (int i = 0; i < 4; ++i) {
+        glEnable(GL_CLIP_DISTANCE0 + i);
+    }
 
 
     const char* modelPath = "models/plane.obj";
 
+    ResourceTracker& resources = ResourceTracker::instance();
+    resources.setBudget(RESOURCE_GPU_BUFFER, GPU_BUFFER_BUDGET);
+    resources.setBudget(RESOURCE_GPU_TEXTURE, GPU_TEXTURE_BUDGET);
+    resources.setBudget(RESOURCE_CPU_MESH, CPU_MESH_BUDGET);
+
     Shader* shader = new Shader();
-    Model* model = new Model(modelPath);
-    SolarSystem* solarSystem = new SolarSystem(shader, model);
+    // Копия вершин нужна SolarSystem для построения BVH выбора, после чего она освобождается
+    Model* model = new Model(modelPath, true);
+    SolarSystem* solarSystem = new SolarSystem(shader, model, scenePath);
+    resources.report(std::cout);
+
+    TextureStreamer textureStreamer(TEXTURE_STREAMING_BUDGET);
+    for (Texture* texture : solarSystem->getTextures()) {
+        textureStreamer.registerTexture(texture);
+    }
 
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), static_cast<float>(SCR_WIDTH) / static_cast<float>(SCR_HEIGHT), 0.1f, 500.0f);
     shader->use();
-    shader->setMat4("projection", projection);
     shader->setInt("texture_diffuse", 0);
 
-    sf::Clock clock;
+    // Матрицы видов и проекций строятся каждый кадр в MultiView
+    View_Layout viewLayout = VIEW_LAYOUT_SINGLE;
+    MultiView views;
+    MultiViewBenchmark viewBenchmark;
+
+    DynamicResolution dynamicResolution(GPU_SCENE_BUDGET_MS);
+    dynamicResolution.resize(SCR_WIDTH, SCR_HEIGHT);
+    auto lastTitleUpdate = std::chrono::steady_clock::now();
+
+    FrameCapture* capture = nullptr;
+
+    FramePacer pacer(TARGET_FPS);
     bool isWindowFocused = true;
     float xCenter = SCR_WIDTH / 2.0f;
     float yCenter = SCR_HEIGHT / 2.0f;
 
     while (window.isOpen()) {
-        float currentFrame = clock.getElapsedTime().asSeconds();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        deltaTime = pacer.waitForNextFrame();
 
         sf::Event event;
         while (window.pollEvent(event)) {
@@ -110,14 +215,110 @@ int main() {
             if (event.type == sf::Event::KeyPressed) {
                 if (event.key.code == sf::Keyboard::Escape)
                     window.close();
-                processInput(event.key.code, deltaTime);
+                if (event.key.code == sf::Keyboard::F2)
+                    textureStreamer.report(std::cout);
+                if (event.key.code == sf::Keyboard::F3)
+                    resources.report(std::cout);
+                // F4 - статистика импосторов, F9 - включить/выключить импосторы для сравнения
+                if (event.key.code == sf::Keyboard::F4)
+                    solarSystem->reportImpostors(std::cout);
+                if (event.key.code == sf::Keyboard::F9) {
+                    solarSystem->setImpostorsEnabled(!solarSystem->areImpostorsEnabled());
+                    std::cout << "Impostors " << (solarSystem->areImpostorsEnabled() ? "enabled" : "disabled") << std::endl;
+                }
+                // F1 - статистика отсечения кластеров, F10 - кластеры/вся сетка для сравнения
+                if (event.key.code == sf::Keyboard::F1)
+                    solarSystem->reportMeshlets(std::cout);
+                if (event.key.code == sf::Keyboard::F10) {
+                    solarSystem->setMeshletsEnabled(!solarSystem->areMeshletsEnabled());
+                    std::cout << "Meshlets " << (solarSystem->areMeshletsEnabled() ? "enabled" : "disabled") << std::endl;
+                }
+                // C - столкновения и сближения тел
+                if (event.key.code == sf::Keyboard::C)
+                    solarSystem->reportProximity(std::cout);
+                // T - следы орбит
+                if (event.key.code == sf::Keyboard::T) {
+                    solarSystem->setOrbitTrailsEnabled(!solarSystem->areOrbitTrailsEnabled());
+                    std::cout << "Orbit trails " << (solarSystem->areOrbitTrailsEnabled() ? "enabled" : "disabled") << std::endl;
+                }
+                // F5 - один вид, F6 - стерео, F7 - четыре вида; F8 - сравнение с рисованием видов по очереди
+                if (event.key.code == sf::Keyboard::F5 || event.key.code == sf::Keyboard::F6 || event.key.code == sf::Keyboard::F7) {
+                    if (event.key.code == sf::Keyboard::F5)
+                        viewLayout = VIEW_LAYOUT_SINGLE;
+                    else if (event.key.code == sf::Keyboard::F6)
+                        viewLayout = VIEW_LAYOUT_STEREO;
+                    else
+                        viewLayout = VIEW_LAYOUT_QUAD;
+                    std::cout << "View layout: " << getViewLayoutName(viewLayout) << std::endl;
+                }
+                if (event.key.code == sf::Keyboard::F8 && !viewBenchmark.isRunning())
+                    viewBenchmark.start(MULTI_VIEW_BENCHMARK_FRAMES, views.getViewCount());
+                // F11 - динамическое разрешение: билинейное увеличение -> с повышением резкости -> выключено
+                if (event.key.code == sf::Keyboard::F11) {
+                    if (!dynamicResolution.isEnabled()) {
+                        dynamicResolution.setEnabled(true);
+                        dynamicResolution.setFilter(UPSCALE_BILINEAR);
+                    }
+                    else if (dynamicResolution.getFilter() == UPSCALE_BILINEAR) {
+                        dynamicResolution.setFilter(UPSCALE_SHARPEN);
+                    }
+                    else {
+                        dynamicResolution.setEnabled(false);
+                    }
+                }
+                // F12 - запись в .y4m, Shift+F12 - последовательность .ppm; повторное нажатие останавливает запись
+                if (event.key.code == sf::Keyboard::F12) {
+                    if (capture) {
+                        delete capture;
+                        capture = nullptr;
+                    }
+                    else {
+                        ++captureCount;
+                        std::string name = "capture_" + std::to_string(captureCount);
+                        if (event.key.shift)
+                            capture = new FrameCapture(windowWidth, windowHeight, name, CAPTURE_PPM);
+                        else
+                            capture = new FrameCapture(windowWidth, windowHeight, name + ".y4m", CAPTURE_Y4M);
+                    }
+                }
+            }
+
+            // Выбор тела под курсором
+            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                auto pickStart = std::chrono::steady_clock::now();
+                // Луч строится в том виде раскладки, над которым курсор
+                glm::vec2 cursorNdc(2.0f * event.mouseButton.x / windowWidth - 1.0f, 1.0f - 2.0f * event.mouseButton.y / windowHeight);
+                int viewIndex = views.getViewAt(cursorNdc);
+                PickResult picked = PickResult();
+                if (viewIndex >= 0) {
+                    Ray ray;
+                    ray.Origin = views.getView(viewIndex).Position;
+                    ray.Direction = getRayDirection(views.getView(viewIndex), cursorNdc);
+                    picked = solarSystem->pick(ray);
+                }
+                double pickUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - pickStart).count();
+
+                if (!picked.Hit)
+                    std::cout << "Pick: nothing under cursor (" << pickUs << " us)" << std::endl;
+                else if (picked.IsSun)
+                    std::cout << "Pick: sun at distance " << picked.Distance << " (" << pickUs << " us)" << std::endl;
+                else {
+                    std::vector<ProximityPair> neighbors;
+                    solarSystem->findNeighbors(picked.BodyIndex, CLOSE_APPROACH_DISTANCE, neighbors);
+                    std::cout << "Pick: body #" << picked.BodyIndex << " at distance " << picked.Distance << " (" << pickUs << " us), "
+                        << neighbors.size() << " bodies closer than " << CLOSE_APPROACH_DISTANCE << std::endl;
+                }
             }
 
             if (event.type == sf::Event::Resized) {
-                glViewport(0, 0, event.size.width, event.size.height);
-                projection = glm::perspective(glm::radians(camera.Zoom), static_cast<float>(event.size.width) / static_cast<float>(event.size.height), 0.1f, 100.0f);
-                shader->use();
-                shader->setMat4("projection", projection);
+                windowWidth = event.size.width;
+                windowHeight = event.size.height;
+                // Размер кадров записи фиксирован, поэтому при изменении окна запись останавливается
+                if (capture) {
+                    delete capture;
+                    capture = nullptr;
+                }
+                dynamicResolution.resize(static_cast<int>(windowWidth), static_cast<int>(windowHeight));
             }
 
             if (event.type == sf::Event::GainedFocus)
@@ -128,24 +329,57 @@ int main() {
             }
         }
 
-        if (isWindowFocused) {
-            updateMouseMovement(window, xCenter, yCenter);
-        }
-
         solarSystem->update(deltaTime);
 
+        // Сцена рисуется в промежуточный буфер в прямоугольник уменьшенного размера
+        dynamicResolution.beginFrame();
         glClearColor(0.0f, 0.0f, 0.2f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glm::mat4 view = camera.getViewMatrix();
-        shader->use();
-        shader->setMat4("view", view);
+        // Ввод опрашивается как можно позже - непосредственно перед построением видов
+        if (isWindowFocused) {
+            processInput(deltaTime);
+            updateMouseMovement(window, xCenter, yCenter);
+        }
+        pacer.markInputSampled();
+
+        views.setup(viewLayout, camera, dynamicResolution.getRenderWidth(), dynamicResolution.getRenderHeight());
+        solarSystem->requestTextureDetail(textureStreamer, views);
+        textureStreamer.update();
+
+        if (viewBenchmark.isRunning()) {
+            viewBenchmark.beginFrame();
+            if (viewBenchmark.isNaivePass()) {
+                for (int i = 0; i < views.getViewCount(); ++i) {
+                    solarSystem->draw(views.extractView(i));
+                }
+            }
+            else {
+                solarSystem->draw(views);
+            }
+            viewBenchmark.endFrame(std::cout);
+        }
+        else {
+            solarSystem->draw(views);
+        }
+
+        dynamicResolution.endFrame();
+
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<float>(now - lastTitleUpdate).count() >= TITLE_UPDATE_INTERVAL) {
+            window.setTitle(formatWindowTitle(dynamicResolution));
+            lastTitleUpdate = now;
+        }
 
-        solarSystem->draw();
+        if (capture)
+            capture->captureFrame();
 
         window.display();
+        pacer.markPresented();
+        pacer.reportEvery(5.0f, std::cout);
     }
 
+    delete capture;
     delete solarSystem;
     delete model;
     delete shader;
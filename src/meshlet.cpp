@@ -0,0 +1,523 @@
+﻿#include "../headers/meshlet.h"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Насколько расхождение нормалей важнее одной новой вершины при наращивании кластера
+const float MESHLET_CONE_WEIGHT = 0.5f;
+
+// Если нормали кластера расходятся сильнее (минимальный косинус к оси меньше), конус не строится
+const float MESHLET_MIN_CONE_DOT = 0.1f;
+
+// Число широтных поясов при упорядочивании кластеров по оси конуса
+const float MESHLET_SORT_BANDS = 8.0f;
+
+static bool lessPosition(const glm::vec3& a, const glm::vec3& b) {
+    if (a.x != b.x)
+        return a.x < b.x;
+    if (a.y != b.y)
+        return a.y < b.y;
+    return a.z < b.z;
+}
+
+/**
+ * @brief Номер уникального значения для каждого элемента: equal(a, b) и less(a, b) задают порядок.
+ * @return Число уникальных значений; first[k] - первый элемент с номером k.
+ */
+template <typename Less, typename Equal>
+static uint32_t assignUnique(size_t count, Less less, Equal equal, std::vector<uint32_t>& ids, std::vector<uint32_t>& first) {
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), less);
+
+    ids.resize(count);
+    first.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (i == 0 || !equal(order[i - 1], order[i]))
+            first.push_back(order[i]);
+        ids[order[i]] = static_cast<uint32_t>(first.size() - 1);
+    }
+    return static_cast<uint32_t>(first.size());
+}
+
+static glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    glm::vec3 n = glm::cross(b - a, c - a);
+    float length = glm::length(n);
+    return length > 0.0f ? n / length : glm::vec3(0.0f);
+}
+
+/**
+ * @brief Проверяет, что каждое ребро (по сваренным позициям) входит ровно в два треугольника
+ * * с противоположным обходом, т.е. сетка замкнута и ориентирована согласованно.
+ */
+static bool isClosedManifold(const std::vector<uint32_t>& welded, size_t triangleCount) {
+    std::vector<uint64_t> edges;
+    edges.reserve(triangleCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int e = 0; e < 3; ++e) {
+            uint64_t a = welded[t * 3 + e];
+            uint64_t b = welded[t * 3 + (e + 1) % 3];
+            edges.push_back((a << 32) | b);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (i + 1 < edges.size() && edges[i] == edges[i + 1])
+            return false;
+        uint64_t reversed = (edges[i] << 32) | (edges[i] >> 32);
+        if (!std::binary_search(edges.begin(), edges.end(), reversed))
+            return false;
+    }
+    return !edges.empty();
+}
+
+static uint32_t hashFloat(uint32_t hash, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 4; ++i) {
+        hash ^= (bits >> (i * 8)) & 0xffu;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+MeshletSource computeMeshletSource(const std::vector<Vertex>& triangleVertices) {
+    MeshletSource source;
+    source.TriangleCount = 0;
+    source.Hash = 2166136261u;
+    for (size_t v = 0; v < triangleVertices.size(); ++v) {
+        const Vertex& vertex = triangleVertices[v];
+        source.Hash = hashFloat(source.Hash, vertex.Position.x);
+        source.Hash = hashFloat(source.Hash, vertex.Position.y);
+        source.Hash = hashFloat(source.Hash, vertex.Position.z);
+        source.Hash = hashFloat(source.Hash, vertex.TexCoords.x);
+        source.Hash = hashFloat(source.Hash, vertex.TexCoords.y);
+    }
+    // Сварка в build() объединяет вершины с равными позициями, поэтому и вырожденность - по позициям
+    for (size_t v = 0; v + 2 < triangleVertices.size(); v += 3) {
+        const glm::vec3& a = triangleVertices[v].Position;
+        const glm::vec3& b = triangleVertices[v + 1].Position;
+        const glm::vec3& c = triangleVertices[v + 2].Position;
+        if (a != b && b != c && a != c)
+            ++source.TriangleCount;
+    }
+    return source;
+}
+
+MeshletMesh::MeshletMesh() : m_coneCulling(false) {
+    m_source = MeshletSource();
+}
+
+bool MeshletMesh::build(const std::vector<Vertex>& triangleVertices) {
+    m_vertices.clear();
+    m_indices.clear();
+    m_meshlets.clear();
+    m_coneCulling = false;
+    m_source = MeshletSource();
+
+    if (triangleVertices.empty() || triangleVertices.size() % 3 != 0) {
+        std::cerr << "ERROR::MESHLET::BUILD: Expected a non-empty triangle list, got " << triangleVertices.size() << " vertices." << std::endl;
+        return false;
+    }
+
+    // Вершины для отрисовки объединяются по позиции и текстурным координатам,
+    // для связности - только по позиции, чтобы кластеры не рвались на швах развёртки
+    std::vector<uint32_t> unique, uniqueFirst;
+    assignUnique(triangleVertices.size(),
+        [&](uint32_t a, uint32_t b) {
+            const Vertex& va = triangleVertices[a];
+            const Vertex& vb = triangleVertices[b];
+            if (va.Position != vb.Position)
+                return lessPosition(va.Position, vb.Position);
+            if (va.TexCoords.x != vb.TexCoords.x)
+                return va.TexCoords.x < vb.TexCoords.x;
+            return va.TexCoords.y < vb.TexCoords.y;
+        },
+        [&](uint32_t a, uint32_t b) {
+            return triangleVertices[a].Position == triangleVertices[b].Position &&
+                triangleVertices[a].TexCoords == triangleVertices[b].TexCoords;
+        },
+        unique, uniqueFirst);
+
+    std::vector<uint32_t> welded, weldedFirst;
+    uint32_t weldedCount = assignUnique(triangleVertices.size(),
+        [&](uint32_t a, uint32_t b) { return lessPosition(triangleVertices[a].Position, triangleVertices[b].Position); },
+        [&](uint32_t a, uint32_t b) { return triangleVertices[a].Position == triangleVertices[b].Position; },
+        welded, weldedFirst);
+
+    m_vertices.reserve(uniqueFirst.size());
+    for (uint32_t first : uniqueFirst) {
+        m_vertices.push_back(triangleVertices[first]);
+    }
+
+    // Вырожденные треугольники (например, на полюсах сферы) ничего не рисуют и ломают проверку рёбер
+    std::vector<uint32_t> triIndices;
+    std::vector<uint32_t> triWelded;
+    triIndices.reserve(triangleVertices.size());
+    triWelded.reserve(triangleVertices.size());
+    for (size_t v = 0; v < triangleVertices.size(); v += 3) {
+        uint32_t a = welded[v], b = welded[v + 1], c = welded[v + 2];
+        if (a == b || b == c || a == c)
+            continue;
+        for (size_t k = 0; k < 3; ++k) {
+            triIndices.push_back(unique[v + k]);
+            triWelded.push_back(welded[v + k]);
+        }
+    }
+    size_t triangleCount = triIndices.size() / 3;
+    if (triangleCount == 0) {
+        std::cerr << "ERROR::MESHLET::BUILD: Mesh has only degenerate triangles." << std::endl;
+        m_vertices.clear();
+        return false;
+    }
+
+    // Нормали граней наружу: знак объёма замкнутой сетки показывает, куда направлен обход
+    std::vector<glm::vec3> normals(triangleCount);
+    float volume = 0.0f;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const glm::vec3& a = m_vertices[triIndices[t * 3 + 0]].Position;
+        const glm::vec3& b = m_vertices[triIndices[t * 3 + 1]].Position;
+        const glm::vec3& c = m_vertices[triIndices[t * 3 + 2]].Position;
+        normals[t] = triangleNormal(a, b, c);
+        volume += glm::dot(a, glm::cross(b, c));
+    }
+    m_coneCulling = isClosedManifold(triWelded, triangleCount);
+    if (volume < 0.0f) {
+        for (glm::vec3& n : normals) {
+            n = -n;
+        }
+    }
+
+    // Смежность: треугольники, содержащие сваренную вершину
+    std::vector<uint32_t> adjacencyOffsets(weldedCount + 1, 0);
+    for (uint32_t w : triWelded) {
+        ++adjacencyOffsets[w + 1];
+    }
+    for (uint32_t w = 0; w < weldedCount; ++w) {
+        adjacencyOffsets[w + 1] += adjacencyOffsets[w];
+    }
+    std::vector<uint32_t> adjacency(triWelded.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < triWelded.size(); ++i) {
+        adjacency[fill[triWelded[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<bool> used(triangleCount, false);
+    // Номер кластера, в кандидаты которого треугольник уже попал: без повторов в списке
+    std::vector<uint32_t> candidateOf(triangleCount, std::numeric_limits<uint32_t>::max());
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint32_t> meshletTriangles;
+    std::vector<uint32_t> candidates;
+    meshletVertices.reserve(MESHLET_MAX_VERTICES);
+    meshletTriangles.reserve(MESHLET_MAX_TRIANGLES);
+    m_indices.reserve(triIndices.size());
+
+    auto newVertexCount = [&](uint32_t t) {
+        uint32_t count = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (std::find(meshletVertices.begin(), meshletVertices.end(), triIndices[t * 3 + k]) == meshletVertices.end())
+                ++count;
+        }
+        return count;
+    };
+
+    size_t seed = 0;
+    while (true) {
+        while (seed < triangleCount && used[seed])
+            ++seed;
+        if (seed == triangleCount)
+            break;
+
+        meshletVertices.clear();
+        meshletTriangles.clear();
+        candidates.clear();
+        glm::vec3 normalSum(0.0f);
+
+        uint32_t meshletIndex = static_cast<uint32_t>(m_meshlets.size());
+        uint32_t next = static_cast<uint32_t>(seed);
+        while (true) {
+            used[next] = true;
+            meshletTriangles.push_back(next);
+            normalSum += normals[next];
+            for (int k = 0; k < 3; ++k) {
+                uint32_t index = triIndices[next * 3 + k];
+                if (std::find(meshletVertices.begin(), meshletVertices.end(), index) == meshletVertices.end())
+                    meshletVertices.push_back(index);
+                uint32_t w = triWelded[next * 3 + k];
+                for (uint32_t a = adjacencyOffsets[w]; a < adjacencyOffsets[w + 1]; ++a) {
+                    uint32_t t = adjacency[a];
+                    if (!used[t] && candidateOf[t] != meshletIndex) {
+                        candidateOf[t] = meshletIndex;
+                        candidates.push_back(t);
+                    }
+                }
+            }
+            if (meshletTriangles.size() >= MESHLET_MAX_TRIANGLES)
+                break;
+
+            // Следующий треугольник - соседний, добавляющий меньше вершин и ближе по нормали
+            glm::vec3 averageNormal = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3(0.0f);
+            float bestScore = std::numeric_limits<float>::max();
+            uint32_t best = 0;
+            bool found = false;
+            size_t kept = 0;
+            for (uint32_t t : candidates) {
+                if (used[t])
+                    continue;
+                candidates[kept++] = t;
+                uint32_t added = newVertexCount(t);
+                if (meshletVertices.size() + added > MESHLET_MAX_VERTICES)
+                    continue;
+                float score = static_cast<float>(added) + MESHLET_CONE_WEIGHT * (1.0f - glm::dot(normals[t], averageNormal));
+                if (score < bestScore) {
+                    bestScore = score;
+                    best = t;
+                    found = true;
+                }
+            }
+            candidates.resize(kept);
+            if (!found)
+                break;
+            next = best;
+        }
+
+        Meshlet meshlet;
+        meshlet.FirstIndex = static_cast<uint32_t>(m_indices.size());
+        meshlet.IndexCount = static_cast<uint32_t>(meshletTriangles.size() * 3);
+        for (uint32_t t : meshletTriangles) {
+            m_indices.push_back(triIndices[t * 3 + 0]);
+            m_indices.push_back(triIndices[t * 3 + 1]);
+            m_indices.push_back(triIndices[t * 3 + 2]);
+        }
+
+        glm::vec3 boundsMin = m_vertices[meshletVertices[0]].Position;
+        glm::vec3 boundsMax = boundsMin;
+        for (uint32_t index : meshletVertices) {
+            boundsMin = glm::min(boundsMin, m_vertices[index].Position);
+            boundsMax = glm::max(boundsMax, m_vertices[index].Position);
+        }
+        meshlet.Center = (boundsMin + boundsMax) * 0.5f;
+        meshlet.Radius = 0.0f;
+        for (uint32_t index : meshletVertices) {
+            meshlet.Radius = std::max(meshlet.Radius, glm::length(m_vertices[index].Position - meshlet.Center));
+        }
+
+        // Конус: ось - средняя нормаль, cutoff - синус половины раствора
+        meshlet.ConeAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        meshlet.ConeCutoff = 1.0f;
+        if (glm::length(normalSum) > 0.0f) {
+            glm::vec3 axis = glm::normalize(normalSum);
+            float minDot = 1.0f;
+            for (uint32_t t : meshletTriangles) {
+                minDot = std::min(minDot, glm::dot(normals[t], axis));
+            }
+            if (minDot >= MESHLET_MIN_CONE_DOT) {
+                meshlet.ConeAxis = axis;
+                meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+            }
+        }
+        m_meshlets.push_back(meshlet);
+    }
+
+    sortByConeAxis();
+    m_source = computeMeshletSource(triangleVertices);
+    return true;
+}
+
+bool MeshletMesh::matchesSource(const std::vector<Vertex>& triangleVertices) const {
+    MeshletSource source = computeMeshletSource(triangleVertices);
+    return source.TriangleCount == m_source.TriangleCount && source.Hash == m_source.Hash;
+}
+
+void MeshletMesh::sortByConeAxis() {
+    // Ключ: широтный пояс оси, затем долгота; кластеры без конуса - в конце
+    auto key = [](const Meshlet& m) {
+        if (m.ConeCutoff >= 1.0f)
+            return std::numeric_limits<float>::max();
+        float band = std::floor((m.ConeAxis.y + 1.0f) * 0.5f * MESHLET_SORT_BANDS);
+        float longitude = std::atan2(m.ConeAxis.z, m.ConeAxis.x) + 3.14159265f;
+        return band * 8.0f + longitude;
+    };
+    std::vector<Meshlet> sorted = m_meshlets;
+    std::stable_sort(sorted.begin(), sorted.end(), [&](const Meshlet& a, const Meshlet& b) { return key(a) < key(b); });
+
+    std::vector<uint32_t> indices;
+    indices.reserve(m_indices.size());
+    for (Meshlet& meshlet : sorted) {
+        uint32_t first = static_cast<uint32_t>(indices.size());
+        indices.insert(indices.end(), m_indices.begin() + meshlet.FirstIndex, m_indices.begin() + meshlet.FirstIndex + meshlet.IndexCount);
+        meshlet.FirstIndex = first;
+    }
+    m_meshlets.swap(sorted);
+    m_indices.swap(indices);
+}
+
+void MeshletMesh::releaseGeometry() {
+    std::vector<Vertex>().swap(m_vertices);
+    std::vector<uint32_t>().swap(m_indices);
+}
+
+bool MeshletMesh::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::MESHLET::SAVE: Failed to open file for writing: " << path << std::endl;
+        return false;
+    }
+
+    MeshletFileHeader header = {};
+    std::memcpy(header.Magic, MESHLET_MAGIC, sizeof(header.Magic));
+    header.Version = MESHLET_VERSION;
+    header.VertexCount = static_cast<uint32_t>(m_vertices.size());
+    header.IndexCount = static_cast<uint32_t>(m_indices.size());
+    header.MeshletCount = static_cast<uint32_t>(m_meshlets.size());
+    header.ConeCulling = m_coneCulling ? 1u : 0u;
+    header.SourceTriangleCount = m_source.TriangleCount;
+    header.SourceHash = m_source.Hash;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_vertices.data()), m_vertices.size() * sizeof(Vertex));
+    file.write(reinterpret_cast<const char*>(m_indices.data()), m_indices.size() * sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(m_meshlets.data()), m_meshlets.size() * sizeof(Meshlet));
+
+    if (!file) {
+        std::cerr << "ERROR::MESHLET::SAVE: Failed to write file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool MeshletMesh::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    MeshletFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.Magic, MESHLET_MAGIC, sizeof(header.Magic)) != 0) {
+        std::cerr << "ERROR::MESHLET::LOAD: Not a meshlet file: " << path << std::endl;
+        return false;
+    }
+    if (header.Version != MESHLET_VERSION) {
+        std::cerr << "ERROR::MESHLET::LOAD: Unsupported meshlet version " << header.Version << " in: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<Vertex> vertices(header.VertexCount);
+    std::vector<uint32_t> indices(header.IndexCount);
+    std::vector<Meshlet> meshlets(header.MeshletCount);
+    file.read(reinterpret_cast<char*>(vertices.data()), vertices.size() * sizeof(Vertex));
+    file.read(reinterpret_cast<char*>(indices.data()), indices.size() * sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(meshlets.data()), meshlets.size() * sizeof(Meshlet));
+    if (!file) {
+        std::cerr << "ERROR::MESHLET::LOAD: Truncated meshlet file: " << path << std::endl;
+        return false;
+    }
+
+    for (uint32_t index : indices) {
+        if (index >= vertices.size()) {
+            std::cerr << "ERROR::MESHLET::LOAD: Vertex index out of range in: " << path << std::endl;
+            return false;
+        }
+    }
+    for (const Meshlet& meshlet : meshlets) {
+        if (meshlet.FirstIndex > indices.size() || meshlet.IndexCount > indices.size() - meshlet.FirstIndex) {
+            std::cerr << "ERROR::MESHLET::LOAD: Meshlet index range out of bounds in: " << path << std::endl;
+            return false;
+        }
+    }
+
+    m_vertices.swap(vertices);
+    m_indices.swap(indices);
+    m_meshlets.swap(meshlets);
+    m_coneCulling = header.ConeCulling != 0;
+    m_source.TriangleCount = header.SourceTriangleCount;
+    m_source.Hash = header.SourceHash;
+    return true;
+}
+
+std::string getMeshletPath(const std::string& modelPath) {
+    size_t dot = modelPath.find_last_of('.');
+    size_t slash = modelPath.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return modelPath + ".meshlets";
+    return modelPath.substr(0, dot) + ".meshlets";
+}
+
+void cullMeshlets(const MeshletMesh& mesh, const View* views, int viewCount, const glm::mat4* instances, size_t count,
+    std::vector<DrawElementsIndirectCommand>& commands, MeshletCullStats& stats) {
+    commands.clear();
+
+    const std::vector<Meshlet>& meshlets = mesh.getMeshlets();
+    bool coneCulling = mesh.isConeCullingAllowed();
+    std::vector<glm::vec3> localEyes(static_cast<size_t>(std::max(viewCount, 0)));
+
+    for (size_t i = 0; i < count; ++i) {
+        // Элемент [0][3] занят долей импостора (см. packInstances)
+        glm::mat4 model = instances[i];
+        model[0][3] = 0.0f;
+
+        // Масштаб тел равномерный: обратное преобразование - транспонированный поворот, делённый на масштаб
+        glm::mat3 linear(model);
+        float scale = glm::length(linear[0]);
+        float invScaleSq = scale > 0.0f ? 1.0f / (scale * scale) : 0.0f;
+        glm::vec3 translation(model[3]);
+        for (int v = 0; v < viewCount; ++v) {
+            localEyes[v] = glm::transpose(linear) * (views[v].Position - translation) * invScaleSq;
+        }
+
+        bool open = false;
+        for (const Meshlet& meshlet : meshlets) {
+            uint32_t triangles = meshlet.IndexCount / 3;
+            stats.Triangles += triangles;
+
+            bool visible = false;
+            glm::vec3 center = glm::vec3(model * glm::vec4(meshlet.Center, 1.0f));
+            float radius = meshlet.Radius * scale;
+            for (int v = 0; v < viewCount && !visible; ++v) {
+                visible = isSphereInFrustum(views[v].ViewFrustum, center, radius);
+            }
+            if (!visible) {
+                stats.FrustumCulled += triangles;
+                open = false;
+                continue;
+            }
+
+            // Кластер отбрасывается, только если он повёрнут задней стороной ко всем видам
+            if (coneCulling && meshlet.ConeCutoff < 1.0f) {
+                bool backfacing = true;
+                for (int v = 0; v < viewCount && backfacing; ++v) {
+                    glm::vec3 toCenter = meshlet.Center - localEyes[v];
+                    backfacing = glm::dot(toCenter, meshlet.ConeAxis) >= meshlet.ConeCutoff * glm::length(toCenter) + meshlet.Radius;
+                }
+                if (backfacing) {
+                    stats.ConeCulled += triangles;
+                    open = false;
+                    continue;
+                }
+            }
+
+            // Кластеры лежат в индексном буфере подряд: соседние выжившие сливаются в одну команду
+            if (open && commands.back().FirstIndex + commands.back().Count == meshlet.FirstIndex) {
+                commands.back().Count += meshlet.IndexCount;
+                continue;
+            }
+            DrawElementsIndirectCommand command;
+            command.Count = meshlet.IndexCount;
+            command.InstanceCount = static_cast<uint32_t>(viewCount);
+            command.FirstIndex = meshlet.FirstIndex;
+            command.BaseVertex = 0;
+            // Делитель атрибутов на базовый экземпляр не действует: BaseInstance - номер матрицы
+            command.BaseInstance = static_cast<uint32_t>(i);
+            commands.push_back(command);
+            open = true;
+        }
+    }
+
+    stats.Commands += commands.size();
+}
@@ -0,0 +1,101 @@
+﻿#include "../headers/meshlet_renderer.h"
+#include "../headers/resource_tracker.h"
+#include <cstddef>
+#include <iostream>
+
+MeshletRenderer::MeshletRenderer()
+    : m_VAO(0), m_VBO(0), m_EBO(0), m_instanceVBO(0), m_indirectBuffer(0), m_indexCount(0) {
+}
+
+MeshletRenderer::~MeshletRenderer() {
+    ResourceTracker& tracker = ResourceTracker::instance();
+    GLuint buffers[] = { m_VBO, m_EBO, m_instanceVBO, m_indirectBuffer };
+    for (GLuint buffer : buffers) {
+        if (buffer != 0) {
+            tracker.release(RESOURCE_GPU_BUFFER, buffer);
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+    if (m_VAO != 0) {
+        glDeleteVertexArrays(1, &m_VAO);
+    }
+}
+
+bool MeshletRenderer::isSupported() const {
+    return m_indexCount > 0 && GLEW_ARB_base_instance;
+}
+
+void MeshletRenderer::upload(const MeshletMesh& mesh) {
+    if (m_VAO == 0) {
+        glGenVertexArrays(1, &m_VAO);
+        glGenBuffers(1, &m_VBO);
+        glGenBuffers(1, &m_EBO);
+        glGenBuffers(1, &m_instanceVBO);
+        glGenBuffers(1, &m_indirectBuffer);
+    }
+
+    const std::vector<Vertex>& vertices = mesh.getVertices();
+    const std::vector<uint32_t>& indices = mesh.getIndices();
+    m_indexCount = static_cast<GLsizei>(indices.size());
+
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+
+    // Привязка GL_ELEMENT_ARRAY_BUFFER запоминается в VAO
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    for (int i = 0; i < 4; ++i) {
+        glEnableVertexAttribArray(2 + i);
+        glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    ResourceTracker& tracker = ResourceTracker::instance();
+    tracker.setUsage(RESOURCE_GPU_BUFFER, m_VBO, vertices.size() * sizeof(Vertex), "meshlet vertices");
+    tracker.setUsage(RESOURCE_GPU_BUFFER, m_EBO, indices.size() * sizeof(uint32_t), "meshlet indices");
+}
+
+void MeshletRenderer::draw(const std::vector<glm::mat4>& instances, GLuint viewCount,
+    const std::vector<DrawElementsIndirectCommand>& commands) {
+    if (commands.empty() || instances.empty()) {
+        return;
+    }
+    if (!isSupported()) {
+        std::cerr << "ERROR::MESHLET_RENDERER::DRAW: GL_ARB_base_instance is not supported or mesh not uploaded." << std::endl;
+        return;
+    }
+
+    ResourceTracker& tracker = ResourceTracker::instance();
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::mat4), instances.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    tracker.setUsage(RESOURCE_GPU_BUFFER, m_instanceVBO, instances.size() * sizeof(glm::mat4), "meshlet instances");
+
+    glBindVertexArray(m_VAO);
+    for (int i = 0; i < 4; ++i) {
+        glVertexAttribDivisor(2 + i, viewCount);
+    }
+
+    if (GLEW_ARB_multi_draw_indirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+        tracker.setUsage(RESOURCE_GPU_BUFFER, m_indirectBuffer, commands.size() * sizeof(DrawElementsIndirectCommand), "meshlet draw commands");
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, static_cast<GLsizei>(commands.size()), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else {
+        for (const DrawElementsIndirectCommand& command : commands) {
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, static_cast<GLsizei>(command.Count), GL_UNSIGNED_INT,
+                (void*)(command.FirstIndex * sizeof(uint32_t)), static_cast<GLsizei>(command.InstanceCount), command.BaseInstance);
+        }
+    }
+    glBindVertexArray(0);
+}
@@ -1,36 +1,61 @@
 #include "../headers/model.h"
-#include <fstream>
-#include <sstream>
-#include <map>
+#include "../headers/resource_tracker.h"
 #include <limits> 
+#include <algorithm>
 
 Model::~Model() {
+    ResourceTracker& tracker = ResourceTracker::instance();
+    tracker.release(RESOURCE_GPU_BUFFER, VBO);
+    tracker.release(RESOURCE_CPU_MESH, reinterpret_cast<uintptr_t>(this));
+
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     if (instanceVBO != 0) {
+        tracker.release(RESOURCE_GPU_BUFFER, instanceVBO);
         glDeleteBuffers(1, &instanceVBO);
     }
 }
 
-Model::Model(const char* path) {
+Model::Model(const char* path, bool retainCpuData) {
     instanceVBO = 0;
+    vertexCount = 0;
+    boundingRadius = 0.0f;
+    boundsMin = glm::vec3(0.0f);
+    boundsMax = glm::vec3(0.0f);
+    name = path;
     loadModel(path);
     setupMesh();
+
+    if (retainCpuData) {
+        ResourceTracker::instance().setUsage(RESOURCE_CPU_MESH, reinterpret_cast<uintptr_t>(this),
+            vertices.capacity() * sizeof(Vertex), name + " (vertices)");
+    }
+    else {
+        releaseCpuData();
+    }
 }
 
-void Model::draw() {
-    if (vertices.empty()) {
+void Model::releaseCpuData() {
+    std::vector<Vertex>().swap(vertices);
+    ResourceTracker::instance().release(RESOURCE_CPU_MESH, reinterpret_cast<uintptr_t>(this));
+}
+
+void Model::draw(GLuint viewCount) {
+    if (vertexCount == 0) {
         std::cerr << "ERROR::MODEL::DRAW: Model vertices are empty. Check OBJ loading." << std::endl;
         return;
     }
 
     glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+    if (viewCount > 1)
+        glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, viewCount);
+    else
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
     glBindVertexArray(0);
 }
 
 void Model::drawInstanced(GLuint instanceCount) {
-    if (vertices.empty()) {
+    if (vertexCount == 0) {
         std::cerr << "ERROR::MODEL::DRAW_INSTANCED: Model vertices are empty. Check OBJ loading." << std::endl;
         return;
     }
@@ -41,17 +66,18 @@ void Model::drawInstanced(GLuint instanceCount) {
     }
 
     glBindVertexArray(VAO);
-    glDrawArraysInstanced(GL_TRIANGLES, 0, vertices.size(), instanceCount);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, instanceCount);
     glBindVertexArray(0);
 }
 
-void Model::setupInstanceBuffer(const std::vector<glm::mat4>& matrices) {
+void Model::setupInstanceBuffer(const std::vector<glm::mat4>& matrices, GLuint divisor) {
     if (instanceVBO == 0) {
         glGenBuffers(1, &instanceVBO);
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
     glBufferData(GL_ARRAY_BUFFER, matrices.size() * sizeof(glm::mat4), matrices.data(), GL_DYNAMIC_DRAW);
+    ResourceTracker::instance().setUsage(RESOURCE_GPU_BUFFER, instanceVBO, matrices.size() * sizeof(glm::mat4), name + " (instances)");
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
@@ -60,7 +86,7 @@ void Model::setupInstanceBuffer(const std::vector<glm::mat4>& matrices) {
     for (int i = 0; i < 4; ++i) {
         glEnableVertexAttribArray(2 + i);
         glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * vec4Size));
-        glVertexAttribDivisor(2 + i, 1);
+        glVertexAttribDivisor(2 + i, divisor);
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -74,7 +100,9 @@ void Model::setupMesh() {
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    vertexCount = static_cast<GLsizei>(vertices.size());
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    ResourceTracker::instance().setUsage(RESOURCE_GPU_BUFFER, VBO, vertices.size() * sizeof(Vertex), name + " (vertices)");
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -88,83 +116,19 @@ void Model::setupMesh() {
 
 void Model::loadModel(const std::string& path) {
     std::cout << "Loading model from: " << path << std::endl;
-    std::ifstream file(path);
-
-    if (!file.is_open()) {
-        std::cerr << "ERROR::MODEL::LOAD: Failed to open file: " << path << std::endl;
+    if (!loadObj(path, vertices)) {
         return;
     }
 
-    std::vector<glm::vec3> temp_positions;
-    std::vector<glm::vec2> temp_texcoords;
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string type;
-        ss >> type;
-
-        if (type == "v") {
-            glm::vec3 position;
-            ss >> position.x >> position.y >> position.z;
-            temp_positions.push_back(position);
-        }
-        else if (type == "vt") {
-            glm::vec2 texcoord;
-            ss >> texcoord.x >> texcoord.y;
-            temp_texcoords.push_back(texcoord);
-        }
-        else if (type == "f") {
-            std::string vertex_str;
-            std::vector<int> vertex_indices;
-            std::vector<int> texcoord_indices;
-
-            while (ss >> vertex_str) {
-                size_t pos_v = vertex_str.find('/');
-                size_t pos_vt = vertex_str.find('/', pos_v + 1);
-
-                try {
-                    int v_idx = std::stoi(vertex_str.substr(0, pos_v));
-                    vertex_indices.push_back(v_idx);
-
-                    int vt_idx = std::stoi(vertex_str.substr(pos_v + 1, pos_vt - (pos_v + 1)));
-                    texcoord_indices.push_back(vt_idx);
-                }
-                catch (const std::exception& e) {
-                    std::cerr << "ERROR::OBJ::PARSING: Invalid face format in line: " << line << " (" << e.what() << ")" << std::endl;
-                    return;
-                }
-            }
-
-            for (size_t i = 0; i < vertex_indices.size() - 2; ++i) {
-                int v_idx_1 = vertex_indices[0];
-                int vt_idx_1 = texcoord_indices[0];
-
-                int v_idx_2 = vertex_indices[i + 1];
-                int vt_idx_2 = texcoord_indices[i + 1];
-
-                int v_idx_3 = vertex_indices[i + 2];
-                int vt_idx_3 = texcoord_indices[i + 2];
-
-                Vertex v1;
-                v1.Position = temp_positions[v_idx_1 - 1];
-                v1.TexCoords = temp_texcoords[vt_idx_1 - 1];
-                vertices.push_back(v1);
-
-                Vertex v2;
-                v2.Position = temp_positions[v_idx_2 - 1];
-                v2.TexCoords = temp_texcoords[vt_idx_2 - 1];
-                vertices.push_back(v2);
-
-                Vertex v3;
-                v3.Position = temp_positions[v_idx_3 - 1];
-                v3.TexCoords = temp_texcoords[vt_idx_3 - 1];
-                vertices.push_back(v3);
-            }
-        }
+    if (!vertices.empty()) {
+        boundsMin = vertices[0].Position;
+        boundsMax = vertices[0].Position;
+    }
+    for (const Vertex& v : vertices) {
+        boundsMin = glm::min(boundsMin, v.Position);
+        boundsMax = glm::max(boundsMax, v.Position);
+        boundingRadius = std::max(boundingRadius, glm::length(v.Position));
     }
-
-    file.close();
 
     std::cout << "Model loaded successfully. Total vertices (after triangulation/expansion): " << vertices.size() << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+﻿#include "../headers/multi_view.h"
+#include <iomanip>
+#include <cmath>
+
+const char* getViewLayoutName(View_Layout layout) {
+    switch (layout) {
+    case VIEW_LAYOUT_STEREO:
+        return "stereo";
+    case VIEW_LAYOUT_QUAD:
+        return "quad";
+    default:
+        return "single";
+    }
+}
+
+// --- MultiView ---
+
+MultiView::MultiView()
+    : m_layout(VIEW_LAYOUT_SINGLE), m_viewCount(0), m_viewportX(0), m_viewportY(0), m_viewportWidth(0), m_viewportHeight(0) {
+}
+
+void MultiView::setup(View_Layout layout, const Camera& camera, int width, int height) {
+    m_layout = layout;
+    m_viewCount = 0;
+    m_viewportX = 0;
+    m_viewportY = 0;
+    m_viewportWidth = width;
+    m_viewportHeight = height;
+
+    float fovY = glm::radians(camera.Zoom);
+    glm::mat4 cameraView = glm::lookAt(camera.Position, camera.Position + camera.Front, camera.Up);
+
+    if (layout == VIEW_LAYOUT_STEREO) {
+        // Параллельные оси глаз, смещённые вдоль Right камеры
+        glm::vec3 offset = camera.Right * (STEREO_EYE_SEPARATION * 0.5f);
+        glm::vec3 leftEye = camera.Position - offset;
+        glm::vec3 rightEye = camera.Position + offset;
+        addView(glm::lookAt(leftEye, leftEye + camera.Front, camera.Up), leftEye, fovY,
+            glm::vec4(-0.5f, 0.0f, 0.5f, 1.0f), width, height);
+        addView(glm::lookAt(rightEye, rightEye + camera.Front, camera.Up), rightEye, fovY,
+            glm::vec4(0.5f, 0.0f, 0.5f, 1.0f), width, height);
+    }
+    else if (layout == VIEW_LAYOUT_QUAD) {
+        glm::vec3 top(0.0f, OVERVIEW_DISTANCE, 0.0f);
+        glm::vec3 side(OVERVIEW_DISTANCE, 0.0f, 0.0f);
+        glm::vec3 front(0.0f, 0.0f, OVERVIEW_DISTANCE);
+        addView(cameraView, camera.Position, fovY,
+            glm::vec4(-0.5f, 0.5f, 0.5f, 0.5f), width, height);
+        addView(glm::lookAt(top, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f)), top, fovY,
+            glm::vec4(0.5f, 0.5f, 0.5f, 0.5f), width, height);
+        addView(glm::lookAt(side, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), side, fovY,
+            glm::vec4(-0.5f, -0.5f, 0.5f, 0.5f), width, height);
+        addView(glm::lookAt(front, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), front, fovY,
+            glm::vec4(0.5f, -0.5f, 0.5f, 0.5f), width, height);
+    }
+    else {
+        addView(cameraView, camera.Position, fovY, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), width, height);
+    }
+}
+
+void MultiView::addView(const glm::mat4& viewMatrix, const glm::vec3& position, float fovY,
+    const glm::vec4& rect, int windowWidth, int windowHeight) {
+    m_views[m_viewCount++] = buildView(viewMatrix, position, fovY, rect, windowWidth, windowHeight);
+}
+
+MultiView MultiView::extractView(int index) const {
+    const View& source = m_views[index];
+
+    MultiView single;
+    single.m_layout = VIEW_LAYOUT_SINGLE;
+    single.m_viewCount = 1;
+    single.m_views[0] = source;
+    single.m_views[0].Rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    single.m_viewportX = source.ViewportX;
+    single.m_viewportY = source.ViewportY;
+    single.m_viewportWidth = source.ViewportWidth;
+    single.m_viewportHeight = source.ViewportHeight;
+    return single;
+}
+
+void MultiView::apply(const Shader& shader) const {
+    glViewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
+
+    glm::mat4 viewProjections[MAX_VIEWS];
+    glm::vec4 rects[MAX_VIEWS];
+    glm::vec4 positions[MAX_VIEWS];
+    for (int i = 0; i < m_viewCount; ++i) {
+        viewProjections[i] = m_views[i].ViewProjection;
+        rects[i] = m_views[i].Rect;
+        positions[i] = glm::vec4(m_views[i].Position, 1.0f);
+    }
+    shader.setMat4Array("viewProjections", viewProjections, m_viewCount);
+    shader.setVec4Array("viewRects", rects, m_viewCount);
+    // Используется шейдерами, которым нужна позиция наблюдателя (импосторы); остальные её не объявляют
+    shader.setVec4Array("viewPositions", positions, m_viewCount);
+    shader.setInt("viewCount", m_viewCount);
+}
+
+bool MultiView::isSphereVisible(const glm::vec3& center, float radius) const {
+    for (int i = 0; i < m_viewCount; ++i) {
+        if (isSphereInFrustum(m_views[i].ViewFrustum, center, radius))
+            return true;
+    }
+    return false;
+}
+
+float MultiView::getProjectedSize(const glm::vec3& center, float radius) const {
+    return ::getProjectedSize(m_views, m_viewCount, center, radius);
+}
+
+int MultiView::getViewAt(const glm::vec2& windowNdc) const {
+    for (int i = 0; i < m_viewCount; ++i) {
+        const glm::vec4& rect = m_views[i].Rect;
+        if (std::abs(windowNdc.x - rect.x) <= rect.z && std::abs(windowNdc.y - rect.y) <= rect.w)
+            return i;
+    }
+    return -1;
+}
+
+// --- MultiViewBenchmark ---
+
+MultiViewBenchmark::MultiViewBenchmark()
+    : m_running(false), m_framesPerPath(0), m_frame(0), m_viewCount(0) {
+    m_cpuMs[0] = 0.0;
+    m_cpuMs[1] = 0.0;
+}
+
+void MultiViewBenchmark::start(int framesPerPath, int viewCount) {
+    m_running = true;
+    m_framesPerPath = framesPerPath;
+    m_frame = 0;
+    m_viewCount = viewCount;
+    for (int path = 0; path < 2; ++path) {
+        m_cpuMs[path] = 0.0;
+        m_gpuTimers[path].reset();
+    }
+}
+
+void MultiViewBenchmark::beginFrame() {
+    m_gpuTimers[isNaivePass() ? 1 : 0].begin();
+    m_frameStart = Clock::now();
+}
+
+void MultiViewBenchmark::endFrame(std::ostream& out) {
+    int path = isNaivePass() ? 1 : 0;
+    m_cpuMs[path] += std::chrono::duration<double, std::milli>(Clock::now() - m_frameStart).count();
+    m_gpuTimers[path].end();
+
+    if (++m_frame < 2 * m_framesPerPath) {
+        return;
+    }
+
+    m_running = false;
+    const char* names[2] = { "single pass", "per-view loop" };
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::fixed << std::setprecision(3);
+    out << "--- Multi-view benchmark: " << m_viewCount << " views, " << m_framesPerPath << " frames per path ---" << std::endl;
+    for (int p = 0; p < 2; ++p) {
+        m_gpuTimers[p].poll(true);
+        out << "    " << names[p] << ": CPU submit " << m_cpuMs[p] / m_framesPerPath << " ms/frame, GPU "
+            << m_gpuTimers[p].getAverageMs() << " ms/frame (" << m_gpuTimers[p].getSampleCount() << " samples)" << std::endl;
+    }
+    if (m_cpuMs[0] > 0.0)
+        out << "    CPU submit speedup: " << m_cpuMs[1] / m_cpuMs[0] << "x" << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
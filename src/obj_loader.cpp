@@ -0,0 +1,87 @@
+#include "../headers/obj_loader.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+bool loadObj(const std::string& path, std::vector<Vertex>& vertices) {
+    std::ifstream file(path);
+
+    if (!file.is_open()) {
+        std::cerr << "ERROR::MODEL::LOAD: Failed to open file: " << path << std::endl;
+        return false;
+    }
+    return parseObj(file, vertices, path);
+}
+
+bool parseObj(std::istream& in, std::vector<Vertex>& vertices, const std::string& sourceName) {
+    std::vector<glm::vec3> temp_positions;
+    std::vector<glm::vec2> temp_texcoords;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string type;
+        ss >> type;
+
+        if (type == "v") {
+            glm::vec3 position;
+            ss >> position.x >> position.y >> position.z;
+            temp_positions.push_back(position);
+        }
+        else if (type == "vt") {
+            glm::vec2 texcoord;
+            ss >> texcoord.x >> texcoord.y;
+            temp_texcoords.push_back(texcoord);
+        }
+        else if (type == "f") {
+            std::string vertex_str;
+            std::vector<int> vertex_indices;
+            std::vector<int> texcoord_indices;
+
+            while (ss >> vertex_str) {
+                size_t pos_v = vertex_str.find('/');
+                size_t pos_vt = vertex_str.find('/', pos_v + 1);
+
+                try {
+                    int v_idx = std::stoi(vertex_str.substr(0, pos_v));
+                    vertex_indices.push_back(v_idx);
+
+                    int vt_idx = std::stoi(vertex_str.substr(pos_v + 1, pos_vt - (pos_v + 1)));
+                    texcoord_indices.push_back(vt_idx);
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "ERROR::OBJ::PARSING: Invalid face format in " << sourceName << " line: " << line << " (" << e.what() << ")" << std::endl;
+                    return false;
+                }
+            }
+
+            for (size_t i = 0; i + 2 < vertex_indices.size(); ++i) {
+                int v_idx_1 = vertex_indices[0];
+                int vt_idx_1 = texcoord_indices[0];
+
+                int v_idx_2 = vertex_indices[i + 1];
+                int vt_idx_2 = texcoord_indices[i + 1];
+
+                int v_idx_3 = vertex_indices[i + 2];
+                int vt_idx_3 = texcoord_indices[i + 2];
+
+                Vertex v1;
+                v1.Position = temp_positions[v_idx_1 - 1];
+                v1.TexCoords = temp_texcoords[vt_idx_1 - 1];
+                vertices.push_back(v1);
+
+                Vertex v2;
+                v2.Position = temp_positions[v_idx_2 - 1];
+                v2.TexCoords = temp_texcoords[vt_idx_2 - 1];
+                vertices.push_back(v2);
+
+                Vertex v3;
+                v3.Position = temp_positions[v_idx_3 - 1];
+                v3.TexCoords = temp_texcoords[vt_idx_3 - 1];
+                vertices.push_back(v3);
+            }
+        }
+    }
+
+    return true;
+}
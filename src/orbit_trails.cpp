@@ -0,0 +1,181 @@
+﻿#include "../headers/orbit_trails.h"
+#include "../headers/resource_tracker.h"
+#include <algorithm>
+#include <iostream>
+
+static const char* TRAIL_VERTEX_SHADER_CODE = R"(
+#version 330 core
+out float Alpha;
+
+const int MAX_VIEWS = 4;
+
+uniform mat4 viewProjections[MAX_VIEWS];
+uniform vec4 viewRects[MAX_VIEWS];
+uniform int viewCount;
+
+uniform samplerBuffer trailPositions;
+uniform int bodyCount;
+uniform int historyLength;
+uniform int head;
+uniform int sampleCount;
+
+void main()
+{
+    int viewIndex = gl_InstanceID % viewCount;
+    int body = gl_InstanceID / viewCount;
+    int age = gl_VertexID;
+    int slot = (head - age + historyLength) % historyLength;
+    vec4 worldPos = vec4(texelFetch(trailPositions, slot * bodyCount + body).xyz, 1.0);
+    Alpha = 1.0 - float(age) / float(max(sampleCount - 1, 1));
+
+    vec4 clipPos = viewProjections[viewIndex] * worldPos;
+    gl_ClipDistance[0] = clipPos.w + clipPos.x;
+    gl_ClipDistance[1] = clipPos.w - clipPos.x;
+    gl_ClipDistance[2] = clipPos.w + clipPos.y;
+    gl_ClipDistance[3] = clipPos.w - clipPos.y;
+
+    vec4 rect = viewRects[viewIndex];
+    clipPos.xy = clipPos.xy * rect.zw + rect.xy * clipPos.w;
+    gl_Position = clipPos;
+}
+)";
+
+static const char* TRAIL_FRAGMENT_SHADER_CODE = R"(
+#version 330 core
+out vec4 FragColor;
+
+in float Alpha;
+
+uniform vec4 trailColor;
+
+void main()
+{
+    FragColor = vec4(trailColor.rgb, trailColor.a * Alpha);
+}
+)";
+
+const glm::vec4 ORBIT_TRAIL_COLOR(0.55f, 0.75f, 1.0f, 0.6f);
+
+OrbitTrails::OrbitTrails(int historyLength, float sampleInterval)
+    : m_shader(TRAIL_VERTEX_SHADER_CODE, TRAIL_FRAGMENT_SHADER_CODE), m_buffer(0), m_texture(0),
+      m_requestedLength(std::max(historyLength, 2)), m_historyLength(0), m_sampleInterval(sampleInterval),
+      m_sinceSample(0.0f), m_bodyCount(0), m_head(0), m_sampleCount(0) {
+    // Вершины берутся из буферной текстуры, но профиль core требует привязанный VAO
+    glGenVertexArrays(1, &m_VAO);
+
+    m_shader.use();
+    m_shader.setInt("trailPositions", 0);
+}
+
+OrbitTrails::~OrbitTrails() {
+    if (m_buffer != 0) {
+        ResourceTracker::instance().release(RESOURCE_GPU_BUFFER, m_buffer);
+        glDeleteBuffers(1, &m_buffer);
+        glDeleteTextures(1, &m_texture);
+    }
+    glDeleteVertexArrays(1, &m_VAO);
+}
+
+void OrbitTrails::allocate(size_t bodyCount) {
+    m_bodyCount = bodyCount;
+    m_staging.assign(bodyCount, glm::vec4(0.0f));
+    clear();
+    if (bodyCount == 0) {
+        m_historyLength = 0;
+        return;
+    }
+
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    size_t byBudget = ORBIT_TRAIL_BUDGET / (bodyCount * sizeof(glm::vec4));
+    size_t byTexels = static_cast<size_t>(maxTexels) / bodyCount;
+    m_historyLength = static_cast<int>(std::min<size_t>(m_requestedLength, std::min(byBudget, byTexels)));
+    if (m_historyLength < 2) {
+        std::cerr << "WARNING::ORBIT_TRAILS::ALLOCATE: " << bodyCount << " bodies do not fit the trail buffer, trails disabled." << std::endl;
+        m_historyLength = 0;
+        return;
+    }
+    if (m_historyLength < m_requestedLength) {
+        std::cerr << "WARNING::ORBIT_TRAILS::ALLOCATE: Trail length reduced to " << m_historyLength << " samples for "
+            << bodyCount << " bodies." << std::endl;
+    }
+
+    if (m_buffer == 0) {
+        glGenBuffers(1, &m_buffer);
+        glGenTextures(1, &m_texture);
+    }
+    size_t bytes = static_cast<size_t>(m_historyLength) * bodyCount * sizeof(glm::vec4);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    ResourceTracker::instance().setUsage(RESOURCE_GPU_BUFFER, m_buffer, bytes, "orbit trails");
+}
+
+void OrbitTrails::clear() {
+    m_head = 0;
+    m_sampleCount = 0;
+    m_sinceSample = 0.0f;
+}
+
+void OrbitTrails::append(const CelestialBody* bodies, size_t count, float deltaTime) {
+    if (count != m_bodyCount) {
+        allocate(count);
+    }
+    if (m_historyLength == 0) {
+        return;
+    }
+
+    // Строка head обновляется каждый кадр, чтобы след начинался у тела; новая строка - раз в интервал
+    m_sinceSample += deltaTime;
+    if (m_sampleCount == 0) {
+        m_sampleCount = 1;
+    }
+    else if (m_sinceSample >= m_sampleInterval) {
+        m_sinceSample = 0.0f;
+        m_head = (m_head + 1) % m_historyLength;
+        m_sampleCount = std::min(m_sampleCount + 1, m_historyLength);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        m_staging[i] = glm::vec4(bodies[i].Position, 1.0f);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(m_head) * count * sizeof(glm::vec4),
+        count * sizeof(glm::vec4), m_staging.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void OrbitTrails::draw(const MultiView& views) {
+    if (m_historyLength == 0 || m_sampleCount < 2) {
+        return;
+    }
+
+    m_shader.use();
+    views.apply(m_shader);
+    m_shader.setInt("bodyCount", static_cast<int>(m_bodyCount));
+    m_shader.setInt("historyLength", m_historyLength);
+    m_shader.setInt("head", m_head);
+    m_shader.setInt("sampleCount", m_sampleCount);
+    m_shader.setVec4("trailColor", ORBIT_TRAIL_COLOR);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+
+    // Полупрозрачные линии: проверка глубины остаётся, запись - нет
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    glBindVertexArray(m_VAO);
+    glDrawArraysInstanced(GL_LINE_STRIP, 0, m_sampleCount, static_cast<GLsizei>(m_bodyCount * views.getViewCount()));
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
@@ -0,0 +1,125 @@
+﻿#include "../headers/resource_tracker.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+
+static const char* CATEGORY_NAMES[RESOURCE_CATEGORY_COUNT] = {
+    "GPU buffers",
+    "GPU textures",
+    "CPU meshes"
+};
+
+static double toMiB(size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+ResourceTracker& ResourceTracker::instance() {
+    static ResourceTracker tracker;
+    return tracker;
+}
+
+ResourceTracker::ResourceTracker() {
+    for (CategoryState& state : m_categories) {
+        state.Total = 0;
+        state.Peak = 0;
+        state.Budget = 0;
+        state.OverBudget = false;
+    }
+}
+
+void ResourceTracker::setUsage(Resource_Category category, uint64_t id, size_t bytes, const std::string& label) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CategoryState& state = m_categories[category];
+
+    auto it = state.Entries.find(id);
+    if (it != state.Entries.end()) {
+        state.Total -= it->second.Bytes;
+        it->second.Bytes = bytes;
+        it->second.Label = label;
+    }
+    else {
+        Entry entry;
+        entry.Bytes = bytes;
+        entry.Label = label;
+        state.Entries[id] = entry;
+    }
+    state.Total += bytes;
+    state.Peak = std::max(state.Peak, state.Total);
+
+    // Предупреждаем один раз при каждом выходе за бюджет
+    bool overBudget = state.Budget != 0 && state.Total > state.Budget;
+    if (overBudget && !state.OverBudget) {
+        std::cerr << "WARNING::RESOURCES::BUDGET: " << CATEGORY_NAMES[category] << " use " << toMiB(state.Total)
+            << " MiB of " << toMiB(state.Budget) << " MiB budget (last: " << label << ")" << std::endl;
+    }
+    state.OverBudget = overBudget;
+}
+
+void ResourceTracker::release(Resource_Category category, uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CategoryState& state = m_categories[category];
+
+    auto it = state.Entries.find(id);
+    if (it == state.Entries.end()) {
+        return;
+    }
+    state.Total -= it->second.Bytes;
+    state.Entries.erase(it);
+    state.OverBudget = state.Budget != 0 && state.Total > state.Budget;
+}
+
+void ResourceTracker::setBudget(Resource_Category category, size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_categories[category].Budget = bytes;
+}
+
+size_t ResourceTracker::getBudget(Resource_Category category) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_categories[category].Budget;
+}
+
+size_t ResourceTracker::getTotal(Resource_Category category) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_categories[category].Total;
+}
+
+size_t ResourceTracker::getPeak(Resource_Category category) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_categories[category].Peak;
+}
+
+size_t ResourceTracker::getResourceCount(Resource_Category category) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_categories[category].Entries.size();
+}
+
+void ResourceTracker::report(std::ostream& out, size_t topCount) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "--- Resource usage ---" << std::endl;
+    for (int c = 0; c < RESOURCE_CATEGORY_COUNT; ++c) {
+        const CategoryState& state = m_categories[c];
+        out << std::fixed << std::setprecision(2) << CATEGORY_NAMES[c] << ": " << toMiB(state.Total) << " MiB in "
+            << state.Entries.size() << " resources (peak " << toMiB(state.Peak) << " MiB";
+        if (state.Budget != 0)
+            out << ", budget " << toMiB(state.Budget) << " MiB";
+        out << ")" << std::endl;
+
+        std::vector<const Entry*> largest;
+        for (const auto& it : state.Entries) {
+            largest.push_back(&it.second);
+        }
+        size_t shown = std::min(topCount, largest.size());
+        std::partial_sort(largest.begin(), largest.begin() + shown, largest.end(),
+            [](const Entry* a, const Entry* b) { return a->Bytes > b->Bytes; });
+        for (size_t i = 0; i < shown; ++i) {
+            out << "    " << toMiB(largest[i]->Bytes) << " MiB  " << largest[i]->Label << std::endl;
+        }
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
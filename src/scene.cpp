@@ -0,0 +1,369 @@
+﻿#include "../headers/scene.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Предел числа тел одного кольца: защищает от опечаток вроде лишних нулей в count
+const long long SCENE_MAX_RING_BODIES = 100000000;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static CelestialBody makeBody(uint32_t textureIndex, float orbitRadius, float orbitSpeed, float rotationSpeed, float scale, float orbitAngle) {
+    CelestialBody b;
+    b.Position = glm::vec3(0.0f);
+    b.OrbitRadius = orbitRadius;
+    b.OrbitSpeed = orbitSpeed;
+    b.RotationSpeed = rotationSpeed;
+    b.Scale = scale;
+    b.OrbitAngle = orbitAngle;
+    b.RotationAngle = 0.0f;
+    b.TextureIndex = textureIndex;
+    return b;
+}
+
+Scene::Scene()
+    : m_bodies(nullptr), m_bodyCount(0), m_mapping(nullptr), m_mappingSize(0) {
+#ifdef _WIN32
+    m_fileHandle = nullptr;
+    m_mappingHandle = nullptr;
+#endif
+    m_sun = makeBody(0, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+}
+
+Scene::~Scene() {
+    unmap();
+}
+
+void Scene::reset() {
+    unmap();
+    m_sun = makeBody(0, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+    m_texturePaths.clear();
+    m_parsedBodies.clear();
+    m_bodies = nullptr;
+    m_bodyCount = 0;
+}
+
+bool Scene::load(const std::string& path) {
+    reset();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::SCENE::LOAD: Failed to open file: " << path << std::endl;
+        return false;
+    }
+
+    char magic[4] = {};
+    file.read(magic, sizeof(magic));
+    bool isBinary = file.gcount() == sizeof(magic) && std::memcmp(magic, SCENE_MAGIC, sizeof(magic)) == 0;
+    file.close();
+
+    bool ok = isBinary ? mapBinary(path) : loadText(path);
+    if (!ok) {
+        reset();
+    }
+    return ok;
+}
+
+bool Scene::loadText(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::SCENE::LOAD: Failed to open file: " << path << std::endl;
+        return false;
+    }
+
+    std::map<std::string, uint32_t> textureIndices;
+    auto findTexture = [&](const std::string& name, int lineNumber, uint32_t& index) {
+        auto it = textureIndices.find(name);
+        if (it == textureIndices.end()) {
+            std::cerr << "ERROR::SCENE::PARSE: Unknown texture '" << name << "' at " << path << ":" << lineNumber << std::endl;
+            return false;
+        }
+        index = it->second;
+        return true;
+    };
+
+    bool hasSun = false;
+    int lineNumber = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (lineNumber == 1 && line.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            line.erase(0, 3);
+        }
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::stringstream ss(line);
+        std::string type;
+        if (!(ss >> type)) {
+            continue;
+        }
+
+        if (type == "texture") {
+            std::string name, texPath;
+            if (!(ss >> name >> texPath)) {
+                std::cerr << "ERROR::SCENE::PARSE: Expected 'texture <name> <path>' at " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            textureIndices[name] = static_cast<uint32_t>(m_texturePaths.size());
+            m_texturePaths.push_back(texPath);
+        }
+        else if (type == "sun") {
+            std::string tex;
+            float scale, rotationSpeed;
+            uint32_t texIndex;
+            if (!(ss >> tex >> scale >> rotationSpeed)) {
+                std::cerr << "ERROR::SCENE::PARSE: Expected 'sun <texture> <scale> <rotation_speed>' at " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            if (!findTexture(tex, lineNumber, texIndex)) {
+                return false;
+            }
+            m_sun = makeBody(texIndex, 0.0f, 0.0f, rotationSpeed, scale, 0.0f);
+            hasSun = true;
+        }
+        else if (type == "body") {
+            std::string tex;
+            float orbitRadius, orbitSpeed, rotationSpeed, scale, orbitAngle;
+            uint32_t texIndex;
+            if (!(ss >> tex >> orbitRadius >> orbitSpeed >> rotationSpeed >> scale >> orbitAngle)) {
+                std::cerr << "ERROR::SCENE::PARSE: Expected 'body <texture> <orbit_radius> <orbit_speed> <rotation_speed> <scale> <orbit_angle>' at "
+                    << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            if (!findTexture(tex, lineNumber, texIndex)) {
+                return false;
+            }
+            m_parsedBodies.push_back(makeBody(texIndex, orbitRadius, orbitSpeed, rotationSpeed, scale, orbitAngle));
+        }
+        else if (type == "ring") {
+            std::string tex;
+            long long count;
+            float innerRadius, outerRadius, minScale, maxScale, orbitSpeed;
+            unsigned int seed;
+            uint32_t texIndex;
+            if (!(ss >> tex >> count >> innerRadius >> outerRadius >> minScale >> maxScale >> orbitSpeed >> seed)) {
+                std::cerr << "ERROR::SCENE::PARSE: Expected 'ring <texture> <count> <inner_radius> <outer_radius> <min_scale> <max_scale> <orbit_speed> <seed>' at "
+                    << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            if (!findTexture(tex, lineNumber, texIndex)) {
+                return false;
+            }
+            if (innerRadius <= 0.0f || outerRadius < innerRadius) {
+                std::cerr << "ERROR::SCENE::PARSE: Invalid ring radii at " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            if (count < 0 || count > SCENE_MAX_RING_BODIES) {
+                std::cerr << "ERROR::SCENE::PARSE: Ring body count " << count << " is out of range [0, " << SCENE_MAX_RING_BODIES
+                    << "] at " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            if (minScale > maxScale) {
+                std::cerr << "ERROR::SCENE::PARSE: Ring min_scale is greater than max_scale at " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+
+            // Кольцо генерируется детерминированно по seed, чтобы компиляция сцены была воспроизводимой
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> radiusDist(innerRadius, outerRadius);
+            std::uniform_real_distribution<float> scaleDist(minScale, maxScale);
+            std::uniform_real_distribution<float> angleDist(0.0f, 360.0f);
+            std::uniform_real_distribution<float> rotationDist(20.0f, 120.0f);
+
+            m_parsedBodies.reserve(m_parsedBodies.size() + static_cast<size_t>(count));
+            for (long long i = 0; i < count; ++i) {
+                float r = radiusDist(rng);
+                // Третий закон Кеплера: внешние тела движутся медленнее
+                float speed = orbitSpeed * std::pow(innerRadius / r, 1.5f);
+                float rotationSpeed = rotationDist(rng);
+                float scale = scaleDist(rng);
+                float orbitAngle = angleDist(rng);
+                m_parsedBodies.push_back(makeBody(texIndex, r, speed, rotationSpeed, scale, orbitAngle));
+            }
+        }
+        else {
+            std::cerr << "ERROR::SCENE::PARSE: Unknown directive '" << type << "' at " << path << ":" << lineNumber << std::endl;
+            return false;
+        }
+    }
+
+    if (!hasSun) {
+        std::cerr << "ERROR::SCENE::PARSE: Scene has no 'sun' directive: " << path << std::endl;
+        return false;
+    }
+
+    m_bodies = m_parsedBodies.data();
+    m_bodyCount = m_parsedBodies.size();
+    return true;
+}
+
+bool Scene::saveBinary(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::SCENE::SAVE: Failed to open file for writing: " << path << std::endl;
+        return false;
+    }
+
+    SceneFileHeader header = {};
+    std::memcpy(header.Magic, SCENE_MAGIC, sizeof(header.Magic));
+    header.Version = SCENE_VERSION;
+    header.TextureCount = static_cast<uint32_t>(m_texturePaths.size());
+    header.BodyStride = sizeof(CelestialBody);
+    header.BodyCount = m_bodyCount;
+    header.TextureTableOffset = sizeof(SceneFileHeader);
+    header.Sun = m_sun;
+
+    uint64_t tableSize = 0;
+    for (const auto& texPath : m_texturePaths) {
+        tableSize += sizeof(uint32_t) + texPath.size();
+    }
+    header.BodiesOffset = alignUp(header.TextureTableOffset + tableSize, 16);
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& texPath : m_texturePaths) {
+        uint32_t length = static_cast<uint32_t>(texPath.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(texPath.data(), length);
+    }
+
+    const char padding[16] = {};
+    file.write(padding, header.BodiesOffset - (header.TextureTableOffset + tableSize));
+    file.write(reinterpret_cast<const char*>(m_bodies), m_bodyCount * sizeof(CelestialBody));
+
+    if (!file) {
+        std::cerr << "ERROR::SCENE::SAVE: Failed to write file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Scene::mapBinary(const std::string& path) {
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        std::cerr << "ERROR::SCENE::MAP: Failed to open file: " << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(fileHandle, &fileSize);
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* data = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data) {
+        std::cerr << "ERROR::SCENE::MAP: Failed to map file: " << path << std::endl;
+        if (mappingHandle) {
+            CloseHandle(mappingHandle);
+        }
+        CloseHandle(fileHandle);
+        return false;
+    }
+    m_fileHandle = fileHandle;
+    m_mappingHandle = mappingHandle;
+    m_mapping = data;
+    m_mappingSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR::SCENE::MAP: Failed to open file: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cerr << "ERROR::SCENE::MAP: Failed to stat file: " << path << std::endl;
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "ERROR::SCENE::MAP: Failed to map file: " << path << std::endl;
+        return false;
+    }
+    // Тела читаются последовательно одним проходом. Советы madvise - значения, а не флаги,
+    // поэтому передаются отдельными вызовами; отказ ядра не мешает чтению
+    if (madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL) != 0 ||
+        madvise(data, static_cast<size_t>(st.st_size), MADV_WILLNEED) != 0) {
+        std::cerr << "WARNING::SCENE::MAP: madvise failed for: " << path << std::endl;
+    }
+    m_mapping = data;
+    m_mappingSize = static_cast<size_t>(st.st_size);
+#endif
+
+    const char* bytes = static_cast<const char*>(m_mapping);
+    if (m_mappingSize < sizeof(SceneFileHeader)) {
+        std::cerr << "ERROR::SCENE::MAP: File is too small for a scene header: " << path << std::endl;
+        return false;
+    }
+
+    SceneFileHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (header.Version != SCENE_VERSION || header.BodyStride != sizeof(CelestialBody)) {
+        std::cerr << "ERROR::SCENE::MAP: Unsupported scene version " << header.Version << " in: " << path << std::endl;
+        return false;
+    }
+    if (header.BodiesOffset % alignof(CelestialBody) != 0 || header.BodiesOffset > m_mappingSize ||
+        header.BodyCount > (m_mappingSize - header.BodiesOffset) / sizeof(CelestialBody)) {
+        std::cerr << "ERROR::SCENE::MAP: Corrupted body table in: " << path << std::endl;
+        return false;
+    }
+
+    uint64_t offset = header.TextureTableOffset;
+    for (uint32_t i = 0; i < header.TextureCount; ++i) {
+        uint32_t length;
+        if (offset + sizeof(length) > header.BodiesOffset) {
+            std::cerr << "ERROR::SCENE::MAP: Corrupted texture table in: " << path << std::endl;
+            return false;
+        }
+        std::memcpy(&length, bytes + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > header.BodiesOffset) {
+            std::cerr << "ERROR::SCENE::MAP: Corrupted texture table in: " << path << std::endl;
+            return false;
+        }
+        m_texturePaths.emplace_back(bytes + offset, length);
+        offset += length;
+    }
+
+    m_sun = header.Sun;
+    m_bodies = reinterpret_cast<const CelestialBody*>(bytes + header.BodiesOffset);
+    m_bodyCount = static_cast<size_t>(header.BodyCount);
+    return true;
+}
+
+void Scene::unmap() {
+    if (m_mapping == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_mapping);
+    CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+    CloseHandle(static_cast<HANDLE>(m_fileHandle));
+    m_fileHandle = nullptr;
+    m_mappingHandle = nullptr;
+#else
+    munmap(m_mapping, m_mappingSize);
+#endif
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_bodies = nullptr;
+    m_bodyCount = 0;
+}
@@ -1,49 +1,4 @@
-#pragma once
-
 #include "../headers/shader.h"
-#include "../headers/model.h"
-#include "../headers/texture.h"
-
-#include <vector>
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
-struct CelestialBody {
-    glm::vec3 Position;
-    float OrbitRadius;
-    float OrbitSpeed;
-    float RotationSpeed;
-    float Scale;
-    float OrbitAngle;
-    float RotationAngle;
-
-    Texture* texture;
-    glm::mat4 ModelMatrix;
-};
-
-
-class SolarSystem {
-public:
-
-    SolarSystem(Shader* shader, Model* model);
-
-    ~SolarSystem();
-
-    void update(float deltaTime);
-
-    void draw();
-
-private:
-    Shader* m_shader;
-    Model* m_model;
-
-    CelestialBody m_sun;
-    std::vector<CelestialBody> m_planets;
-    std::vector<glm::mat4> instanceMatrices;
-
-    void initializeSystem();
-};
-
 
 const char* VERTEX_SHADER_CODE = R"(
 #version 330 core
@@ -52,16 +7,32 @@ layout (location = 1) in vec2 aTexCoord;
 layout (location = 2) in mat4 instanceModel;
 
 out vec2 TexCoord;
+flat out float Fade;
+
+const int MAX_VIEWS = 4;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 viewProjections[MAX_VIEWS];
+uniform vec4 viewRects[MAX_VIEWS];
+uniform int viewCount;
 uniform bool useInstanceMatrix;
 
 void main()
 {
+    int viewIndex = gl_InstanceID % viewCount;
     mat4 finalModel = useInstanceMatrix ? instanceModel : model;
-    gl_Position = projection * view * finalModel * vec4(aPos, 1.0);
+    Fade = finalModel[0][3];
+    finalModel[0][3] = 0.0;
+    vec4 clipPos = viewProjections[viewIndex] * finalModel * vec4(aPos, 1.0);
+
+    gl_ClipDistance[0] = clipPos.w + clipPos.x;
+    gl_ClipDistance[1] = clipPos.w - clipPos.x;
+    gl_ClipDistance[2] = clipPos.w + clipPos.y;
+    gl_ClipDistance[3] = clipPos.w - clipPos.y;
+
+    vec4 rect = viewRects[viewIndex];
+    clipPos.xy = clipPos.xy * rect.zw + rect.xy * clipPos.w;
+    gl_Position = clipPos;
     TexCoord = aTexCoord;
 }
 )";
@@ -71,19 +42,25 @@ const char* FRAGMENT_SHADER_CODE = R"(
 out vec4 FragColor;
 
 in vec2 TexCoord;
+flat in float Fade;
 
 uniform sampler2D texture_diffuse;
 
+const float BAYER[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+
 void main()
 {
+    ivec2 cell = ivec2(gl_FragCoord.xy) & 3;
+    if (Fade > 0.0 && (BAYER[cell.y * 4 + cell.x] + 0.5) / 16.0 < Fade)
+        discard;
     FragColor = texture(texture_diffuse, TexCoord);
 }
 )";
 
-Shader::Shader() {
-    const char* vShaderCode = VERTEX_SHADER_CODE;
-    const char* fShaderCode = FRAGMENT_SHADER_CODE;
+Shader::Shader() : Shader(VERTEX_SHADER_CODE, FRAGMENT_SHADER_CODE) {
+}
 
+Shader::Shader(const char* vShaderCode, const char* fShaderCode) {
     GLuint vertex, fragment;
 
     vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -126,6 +103,10 @@ void Shader::setFloat(const std::string& name, float value) const {
     glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
+    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
     glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
 }
@@ -134,10 +115,22 @@ void Shader::setVec3(const std::string& name, float x, float y, float z) const {
     glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
 }
 
+void Shader::setVec4(const std::string& name, const glm::vec4& value) const {
+    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
+void Shader::setVec4Array(const std::string& name, const glm::vec4* values, int count) const {
+    glUniform4fv(glGetUniformLocation(ID, name.c_str()), count, &values[0][0]);
+}
+
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
     glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
+void Shader::setMat4Array(const std::string& name, const glm::mat4* mats, int count) const {
+    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), count, GL_FALSE, &mats[0][0][0]);
+}
+
 void Shader::checkCompileErrors(GLuint shader, std::string type) {
     GLint success;
     GLchar infoLog[1024];
@@ -1,24 +1,85 @@
 #include "../headers/solar_system.h"
 #include <iostream>
 #include <cmath>
+#include <chrono>
+#include <limits>
+#include <iomanip>
+#include <algorithm>
 
-SolarSystem::SolarSystem(Shader* shader, Model* model)
-    : m_shader(shader), m_model(model) {
-    initializeSystem();
+SolarSystem::SolarSystem(Shader* shader, Model* model, const std::string& scenePath)
+    : m_shader(shader), m_model(model), m_sunMatrix(1.0f), m_visibleBodyCount(0), m_impostorsEnabled(true),
+      m_meshletsEnabled(true), m_meshletCullMs(0.0), m_orbitTrailsEnabled(true),
+      m_spatialHashBuildMs(0.0) {
+    m_impostorStats = ImpostorStats();
+    m_meshletStats = MeshletCullStats();
+    m_meshPathFrames[0] = m_meshPathFrames[1] = 0;
+    m_meshPathInstances[0] = m_meshPathInstances[1] = 0;
+    if (!loadScene(scenePath)) {
+        std::cerr << "WARNING::SOLAR_SYSTEM::SCENE: Falling back to the built-in system." << std::endl;
+        initializeSystem();
+    }
+    groupByTexture();
     instanceMatrices.resize(m_planets.size());
+    m_bounds.resize(m_planets.size() + 1);
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(m_model->getVertices().size());
+    for (const Vertex& v : m_model->getVertices()) {
+        positions.push_back(v.Position);
+    }
+    m_meshBvh.build(positions);
+
+    for (TextureBatch& batch : m_textureBatches) {
+        batch.Atlas = new ImpostorAtlas();
+        batch.Atlas->bake(*m_shader, *m_model, getTexture(batch.TextureIndex));
+    }
+    setupMeshlets();
+
+    //     BVH  ;      GPU
+    m_model->releaseCpuData();
 }
 
 SolarSystem::~SolarSystem() {
-    delete m_sun.texture;
-    for (const auto& p : m_planets) {
-        delete p.texture;
+    for (TextureBatch& batch : m_textureBatches) {
+        delete batch.Atlas;
     }
+    m_textureBatches.clear();
+    for (Texture* texture : m_textures) {
+        delete texture;
+    }
+    m_textures.clear();
     m_planets.clear();
 }
 
+bool SolarSystem::loadScene(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+
+    Scene scene;
+    if (!scene.load(path)) {
+        return false;
+    }
+
+    m_sun = scene.getSun();
+    //   :    memcpy    
+    m_planets.assign(scene.getBodies(), scene.getBodies() + scene.getBodyCount());
+
+    for (const auto& texPath : scene.getTexturePaths()) {
+        m_textures.push_back(new Texture(texPath.c_str(), true));
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << "Scene '" << path << "' loaded (" << (scene.isMapped() ? "memory-mapped" : "parsed") << "): "
+        << m_planets.size() << " bodies, " << m_textures.size() << " textures in " << ms << " ms" << std::endl;
+    return true;
+}
+
 void SolarSystem::initializeSystem() {
     std::cout << "Initializing Solar System with 6 bodies..." << std::endl;
 
+    m_textures.push_back(new Texture("textures/sun_tex.png", true));
+    m_textures.push_back(new Texture("textures/planet_tex.png", true));
+
     m_sun.OrbitRadius = 0.0f;
     m_sun.OrbitSpeed = 0.0f;
     m_sun.RotationSpeed = 15.0f;
@@ -26,7 +87,7 @@ void SolarSystem::initializeSystem() {
     m_sun.RotationAngle = 0.0f;
     m_sun.OrbitAngle = 0.0f;
     m_sun.Position = glm::vec3(0.0f);
-    m_sun.texture = new Texture("textures/sun_tex.png");
+    m_sun.TextureIndex = 0;
 
     float baseRadius = 5.0f;
     float radiusIncrement = 15.0f;
@@ -43,59 +104,340 @@ void SolarSystem::initializeSystem() {
         p.OrbitAngle = (float)(i * 72.0f); 
         p.RotationAngle = 0.0f;
         p.Position = glm::vec3(0.0f);
-
-        std::string texPath = "textures/planet_tex.png";
-        p.texture = new Texture(texPath.c_str());
+        p.TextureIndex = 1;
 
         m_planets.push_back(p);
     }
 }
 
+void SolarSystem::groupByTexture() {
+    std::stable_sort(m_planets.begin(), m_planets.end(),
+        [](const CelestialBody& a, const CelestialBody& b) { return a.TextureIndex < b.TextureIndex; });
+
+    m_textureBatches.clear();
+    for (size_t i = 0; i < m_planets.size(); ++i) {
+        if (m_textureBatches.empty() || m_textureBatches.back().TextureIndex != m_planets[i].TextureIndex) {
+            TextureBatch batch;
+            batch.TextureIndex = m_planets[i].TextureIndex;
+            batch.First = i;
+            batch.Count = 0;
+            batch.Atlas = nullptr;
+            m_textureBatches.push_back(batch);
+        }
+        ++m_textureBatches.back().Count;
+    }
+}
+
+void SolarSystem::setupMeshlets() {
+    auto start = std::chrono::steady_clock::now();
+
+    //    (--build-meshlets),     
+    std::string path = getMeshletPath(m_model->getName());
+    bool loaded = m_meshletMesh.load(path);
+    if (loaded && !m_meshletMesh.matchesSource(m_model->getVertices())) {
+        std::cerr << "WARNING::SOLAR_SYSTEM::MESHLETS: '" << path << "' was built from a different mesh, rebuilding." << std::endl;
+        loaded = false;
+    }
+    if (!loaded && !m_meshletMesh.build(m_model->getVertices())) {
+        std::cerr << "WARNING::SOLAR_SYSTEM::MESHLETS: Meshlets unavailable, drawing whole meshes." << std::endl;
+        m_meshletsEnabled = false;
+        return;
+    }
+
+    m_meshletRenderer.upload(m_meshletMesh);
+    m_meshletMesh.releaseGeometry();
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Meshlets " << (loaded ? "loaded from '" + path + "'" : std::string("built")) << ": "
+        << m_meshletMesh.getMeshlets().size() << " clusters, cone culling "
+        << (m_meshletMesh.isConeCullingAllowed() ? "enabled" : "disabled (mesh is not closed)") << " in " << ms << " ms" << std::endl;
+    if (!m_meshletRenderer.isSupported()) {
+        std::cerr << "WARNING::SOLAR_SYSTEM::MESHLETS: GL_ARB_base_instance is not supported, drawing whole meshes." << std::endl;
+    }
+}
+
+Texture* SolarSystem::getTexture(uint32_t index) const {
+    if (index >= m_textures.size()) {
+        std::cerr << "ERROR::SOLAR_SYSTEM::TEXTURE: Texture index " << index << " is out of range." << std::endl;
+        return nullptr;
+    }
+    return m_textures[index];
+}
+
 void SolarSystem::update(float deltaTime) {
-    m_sun.RotationAngle += m_sun.RotationSpeed * deltaTime;
+    m_sunMatrix = advanceSun(m_sun, deltaTime);
+    advanceBodies(m_planets.data(), m_planets.size(), deltaTime, instanceMatrices.data());
+    if (m_orbitTrailsEnabled) {
+        m_orbitTrails.append(m_planets.data(), m_planets.size(), deltaTime);
+    }
 
-    m_sun.ModelMatrix = glm::mat4(1.0f);
-    m_sun.ModelMatrix = glm::scale(m_sun.ModelMatrix, glm::vec3(m_sun.Scale));
-    m_sun.ModelMatrix = glm::rotate(m_sun.ModelMatrix, glm::radians(m_sun.RotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
-    m_sun.ModelMatrix = glm::rotate(m_sun.ModelMatrix, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    float meshRadius = m_model->getBoundingRadius();
+    computeBodyBounds(&m_sun, 1, meshRadius, &m_bounds[0]);
+    computeBodyBounds(m_planets.data(), m_planets.size(), meshRadius, m_bounds.data() + 1);
+    m_instanceBvh.update(m_bounds);
 
-    for (size_t i = 0; i < m_planets.size(); ++i) {
-        CelestialBody& p = m_planets[i];
-        p.OrbitAngle += p.OrbitSpeed * deltaTime;
+    auto hashStart = std::chrono::steady_clock::now();
+    m_spatialHash.build(m_bounds.data() + 1, m_planets.size(), CLOSE_APPROACH_DISTANCE);
+    m_spatialHashBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - hashStart).count();
+}
+
+PickResult SolarSystem::pick(const Ray& ray) const {
+    PickResult result;
+    result.Hit = false;
+    result.IsSun = false;
+    result.BodyIndex = 0;
+    result.Distance = 0.0f;
+
+    float tHit = std::numeric_limits<float>::max();
+    int64_t index = m_instanceBvh.intersect(ray, tHit, [&](uint32_t body, float& t) {
+        //     ;   ,
+        //   t   
+        glm::mat4 inverseModel = glm::inverse(body == 0 ? m_sunMatrix : instanceMatrices[body - 1]);
+        Ray local;
+        local.Origin = glm::vec3(inverseModel * glm::vec4(ray.Origin, 1.0f));
+        local.Direction = glm::vec3(inverseModel * glm::vec4(ray.Direction, 0.0f));
+        return m_meshBvh.intersect(local, t);
+    });
 
-        p.Position.x = p.OrbitRadius * cos(glm::radians(p.OrbitAngle));
-        p.Position.z = p.OrbitRadius * sin(glm::radians(p.OrbitAngle));
+    if (index >= 0) {
+        result.Hit = true;
+        result.IsSun = index == 0;
+        result.BodyIndex = index == 0 ? 0 : static_cast<size_t>(index - 1);
+        result.Distance = tHit;
+    }
+    return result;
+}
 
-        p.RotationAngle += p.RotationSpeed * deltaTime;
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, p.Position);
-        model = glm::rotate(model, glm::radians(p.RotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        model = glm::scale(model, glm::vec3(p.Scale));
+void SolarSystem::requestTextureDetail(TextureStreamer& streamer, const MultiView& views) const {
+    //       ,        
+    std::vector<float> coverage(m_textures.size(), 0.0f);
+    auto accumulate = [&](const CelestialBody& body, const BoundingSphere& bounds) {
+        if (body.TextureIndex >= coverage.size())
+            return;
+        coverage[body.TextureIndex] = glm::max(coverage[body.TextureIndex], views.getProjectedSize(bounds.Center, bounds.Radius));
+    };
 
-        p.ModelMatrix = model;
-        instanceMatrices[i] = model;
+    accumulate(m_sun, m_bounds[0]);
+    for (size_t i = 0; i < m_planets.size(); ++i) {
+        accumulate(m_planets[i], m_bounds[i + 1]);
     }
 
-    m_model->setupInstanceBuffer(instanceMatrices);
+    for (size_t i = 0; i < m_textures.size(); ++i) {
+        if (coverage[i] > 0.0f)
+            streamer.requestCoverage(m_textures[i], coverage[i]);
+    }
 }
 
-void SolarSystem::draw() {
+void SolarSystem::draw(const MultiView& views) {
     m_shader->use();
+    views.apply(*m_shader);
+    GLuint viewCount = static_cast<GLuint>(views.getViewCount());
 
     //  
-    m_sun.texture->bind(0);
-    m_shader->setMat4("model", m_sun.ModelMatrix);
-    m_shader->setBool("useInstanceMatrix", false);
-    m_model->draw();
-
-    //  
-    m_shader->setBool("useInstanceMatrix", true);
-    m_model->setupInstanceBuffer(instanceMatrices);
-    
-    for (size_t i = 0; i < m_planets.size(); ++i) {
-        m_planets[i].texture->bind(0);
+    if (views.isSphereVisible(m_bounds[0].Center, m_bounds[0].Radius)) {
+        if (Texture* sunTexture = getTexture(m_sun.TextureIndex)) {
+            sunTexture->bind(0);
+        }
+        m_shader->setMat4("model", m_sunMatrix);
+        m_shader->setBool("useInstanceMatrix", false);
+        m_model->draw(viewCount);
+    }
+
+    //     :     ,      
+    size_t meshInstances = 0;
+    size_t impostorInstances = 0;
+    size_t blended = 0;
+    for (TextureBatch& batch : m_textureBatches) {
+        bool useImpostors = m_impostorsEnabled && batch.Atlas->isBaked();
+        blended += packInstances(views.getViews(), views.getViewCount(), m_bounds.data() + 1 + batch.First,
+            instanceMatrices.data() + batch.First, batch.Count, useImpostors, batch.MeshInstances, batch.ImpostorInstances);
+        meshInstances += batch.MeshInstances.size();
+        impostorInstances += batch.ImpostorInstances.size();
+    }
+    m_visibleBodyCount = meshInstances + impostorInstances - blended;
+
+    ++m_impostorStats.Frames;
+    m_impostorStats.MeshInstances += meshInstances;
+    m_impostorStats.ImpostorInstances += impostorInstances;
+    m_impostorStats.BlendedInstances += blended;
+
+    if (meshInstances > 0) {
+        //   -   GPU,   CPU     
+        int path = m_meshletsEnabled && m_meshletRenderer.isSupported() ? 1 : 0;
+        if (path == 1) {
+            ++m_meshletStats.Frames;
+            auto cullStart = std::chrono::steady_clock::now();
+            for (TextureBatch& batch : m_textureBatches) {
+                if (batch.MeshInstances.empty())
+                    continue;
+                cullMeshlets(m_meshletMesh, views.getViews(), views.getViewCount(), batch.MeshInstances.data(),
+                    batch.MeshInstances.size(), batch.MeshletCommands, m_meshletStats);
+            }
+            m_meshletCullMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+        }
+        ++m_meshPathFrames[path];
+        m_meshPathInstances[path] += meshInstances;
+
+        m_meshTimer.begin();
+        m_meshPathTimers[path].begin();
+        m_shader->setBool("useInstanceMatrix", true);
+
+        //         
+        for (TextureBatch& batch : m_textureBatches) {
+            if (batch.MeshInstances.empty())
+                continue;
+            if (Texture* planetTexture = getTexture(batch.TextureIndex)) {
+                planetTexture->bind(0);
+            }
+
+            if (path == 1) {
+                m_meshletRenderer.draw(batch.MeshInstances, viewCount, batch.MeshletCommands);
+            }
+            else {
+                m_model->setupInstanceBuffer(batch.MeshInstances, viewCount);
+                m_model->drawInstanced(static_cast<GLuint>(batch.MeshInstances.size()) * viewCount);
+            }
+        }
+        m_meshPathTimers[path].end();
+        m_meshTimer.end();
+    }
+
+    if (impostorInstances > 0) {
+        m_impostorTimer.begin();
+        for (const TextureBatch& batch : m_textureBatches) {
+            m_impostorRenderer.draw(views, *batch.Atlas, batch.ImpostorInstances);
+        }
+        m_impostorTimer.end();
+    }
+
+    //  ,      
+    if (m_orbitTrailsEnabled) {
+        m_orbitTrails.draw(views);
+    }
+}
+
+void SolarSystem::reportImpostors(std::ostream& out) {
+    m_meshTimer.poll();
+    m_impostorTimer.poll();
+
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    double frames = static_cast<double>(std::max<size_t>(m_impostorStats.Frames, 1));
+    double meshPerFrame = m_impostorStats.MeshInstances / frames;
+    double impostorPerFrame = m_impostorStats.ImpostorInstances / frames;
+    double blendedPerFrame = m_impostorStats.BlendedInstances / frames;
+
+    double meshMs = m_meshTimer.getAverageMs();
+    double impostorMs = m_impostorTimer.getAverageMs();
+
+    out << std::fixed << std::setprecision(3);
+    out << "--- Impostors (" << (m_impostorsEnabled ? "enabled" : "disabled") << "), " << m_impostorStats.Frames << " frames ---" << std::endl;
+    out << "    per frame: " << meshPerFrame << " mesh instances, " << impostorPerFrame << " impostor instances ("
+        << blendedPerFrame << " in transition, drawn both ways)" << std::endl;
+    out << "    GPU per pass: mesh " << meshMs << " ms, impostors " << impostorMs << " ms" << std::endl;
+    if (meshPerFrame > 0.0) {
+        //             
+        double meshMsPerInstance = meshMs / meshPerFrame;
+        double saved = meshMsPerInstance * (impostorPerFrame - blendedPerFrame) - impostorMs;
+        out << "    estimated GPU time saved: " << saved << " ms/frame (mesh " << meshMsPerInstance * 1000.0 << " us/instance)" << std::endl;
+    }
+    else {
+        out << "    estimated GPU time saved: n/a (no mesh instances to measure against)" << std::endl;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+
+    m_impostorStats = ImpostorStats();
+    m_meshTimer.reset();
+    m_impostorTimer.reset();
+}
+
+void SolarSystem::reportMeshlets(std::ostream& out) {
+    m_meshPathTimers[0].poll();
+    m_meshPathTimers[1].poll();
+
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    const MeshletCullStats& stats = m_meshletStats;
+    double triangles = static_cast<double>(std::max<size_t>(stats.Triangles, 1));
+    double cullFrames = static_cast<double>(std::max<size_t>(stats.Frames, 1));
+
+    out << std::fixed << std::setprecision(3);
+    out << "--- Meshlets (" << (m_meshletsEnabled ? "enabled" : "disabled") << "), " << m_meshletMesh.getMeshlets().size()
+        << " clusters, cone culling " << (m_meshletMesh.isConeCullingAllowed() ? "on" : "off (mesh is not closed)") << " ---" << std::endl;
+    if (stats.Frames > 0) {
+        out << "    culled triangles: frustum " << 100.0 * stats.FrustumCulled / triangles << "%, backface cones "
+            << 100.0 * stats.ConeCulled / triangles << "%, drawn "
+            << 100.0 * (stats.Triangles - stats.FrustumCulled - stats.ConeCulled) / triangles << "%" << std::endl;
+        out << "    per frame: " << stats.Commands / cullFrames << " draw commands, CPU culling "
+            << m_meshletCullMs / cullFrames << " ms" << std::endl;
+    }
+
+    //       :      
+    const char* names[2] = { "whole mesh", "meshlets" };
+    double usPerInstance[2] = { 0.0, 0.0 };
+    bool measured[2] = { false, false };
+    for (int i = 0; i < 2; ++i) {
+        out << "    GPU mesh pass, " << names[i] << ": ";
+        if (m_meshPathTimers[i].getSampleCount() == 0 || m_meshPathInstances[i] == 0) {
+            out << "not measured" << std::endl;
+            continue;
+        }
+        double instancesPerFrame = static_cast<double>(m_meshPathInstances[i]) / m_meshPathFrames[i];
+        usPerInstance[i] = m_meshPathTimers[i].getAverageMs() * 1000.0 / instancesPerFrame;
+        measured[i] = true;
+        out << m_meshPathTimers[i].getAverageMs() << " ms (" << usPerInstance[i] << " us/instance)" << std::endl;
+    }
+    if (measured[0] && measured[1]) {
+        out << "    net GPU change with meshlets: " << usPerInstance[1] - usPerInstance[0] << " us/instance ("
+            << 100.0 * (usPerInstance[1] - usPerInstance[0]) / usPerInstance[0] << "%)" << std::endl;
+    }
+    else {
+        out << "    net GPU change: n/a (toggle meshlets with F10 to measure both modes)" << std::endl;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+
+    m_meshletStats = MeshletCullStats();
+    m_meshletCullMs = 0.0;
+    for (int i = 0; i < 2; ++i) {
+        m_meshPathTimers[i].reset();
+        m_meshPathFrames[i] = 0;
+        m_meshPathInstances[i] = 0;
+    }
+}
+
+void SolarSystem::reportProximity(std::ostream& out, float distance) const {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ProximityPair> pairs;
+    m_spatialHash.pairsCloserThan(distance, pairs);
+    double queryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t collisions = 0;
+    for (const ProximityPair& pair : pairs) {
+        if (pair.Gap < 0.0f)
+            ++collisions;
+    }
+
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::fixed << std::setprecision(3);
+    out << "--- Proximity: " << m_spatialHash.getBodyCount() << " bodies, cell " << m_spatialHash.getCellSize()
+        << ", rebuild " << m_spatialHashBuildMs << " ms, query " << queryMs << " ms ---" << std::endl;
+    out << "    collisions: " << collisions << ", closer than " << distance << ": " << pairs.size() - collisions << std::endl;
+
+    const size_t shown = std::min<size_t>(pairs.size(), 5);
+    std::partial_sort(pairs.begin(), pairs.begin() + shown, pairs.end(),
+        [](const ProximityPair& a, const ProximityPair& b) { return a.Gap < b.Gap; });
+    for (size_t i = 0; i < shown; ++i) {
+        out << "    body #" << pairs[i].A << " - body #" << pairs[i].B << ": gap " << pairs[i].Gap << std::endl;
     }
 
-    m_model->drawInstanced(static_cast<GLuint>(m_planets.size()));
+    out.flags(flags);
+    out.precision(precision);
 }
\ No newline at end of file
@@ -0,0 +1,294 @@
+﻿#include "../headers/spatial_hash.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// Меньше тел на часть не даёт выигрыша: передача части потоку дороже работы
+const size_t SPATIAL_HASH_MIN_CHUNK = 16384;
+
+// Разрядов ключа за проход сортировки: гистограмма части - 2048 счётчиков, 8 КБ
+const int SPATIAL_HASH_RADIX_BITS = 11;
+
+static unsigned chooseThreadCount(size_t count, unsigned requested) {
+    unsigned threads = requested != 0 ? requested : std::thread::hardware_concurrency();
+    threads = std::max(threads, 1u);
+    size_t byWork = std::max<size_t>(count / SPATIAL_HASH_MIN_CHUNK, 1);
+    return static_cast<unsigned>(std::min<size_t>(threads, byWork));
+}
+
+/**
+ * @brief Делит [0, count) на partCount частей и вызывает work(begin, end, part) для каждой на потоках pool.
+ */
+template <typename Work>
+static void parallelFor(WorkerPool& pool, size_t count, unsigned partCount, Work work) {
+    pool.run(partCount, [&](unsigned part) {
+        work(count * part / partCount, count * (part + 1) / partCount, part);
+    });
+}
+
+static glm::ivec3 cellOf(const glm::vec3& p, float cellSize) {
+    return glm::ivec3(static_cast<int>(std::floor(p.x / cellSize)),
+        static_cast<int>(std::floor(p.y / cellSize)),
+        static_cast<int>(std::floor(p.z / cellSize)));
+}
+
+SpatialHash::SpatialHash()
+    : m_spheres(nullptr), m_count(0), m_cellSize(1.0f), m_maxRadius(0.0f), m_mask(0), m_compactNeighborhood(false) {
+}
+
+// Соседние по x ячейки попадают в соседние корзины, остальные оси разносятся множителями
+uint32_t SpatialHash::bucketOf(const glm::ivec3& cell) const {
+    uint32_t h = static_cast<uint32_t>(cell.x) + static_cast<uint32_t>(cell.z) * 40503u +
+        static_cast<uint32_t>(cell.y) * 611953u;
+    return h & m_mask;
+}
+
+void SpatialHash::build(const BoundingSphere* spheres, size_t count, float typicalDistance, unsigned threadCount) {
+    m_spheres = spheres;
+    m_count = count;
+
+    uint32_t tableSize = 1;
+    int keyBits = 0;
+    while (tableSize < count) {
+        tableSize <<= 1;
+        ++keyBits;
+    }
+    m_mask = tableSize - 1;
+
+    unsigned parts = chooseThreadCount(count, threadCount);
+    std::vector<float> partMaxRadius(parts, 0.0f);
+    parallelFor(m_pool, count, parts, [&](size_t begin, size_t end, unsigned part) {
+        float maxRadius = 0.0f;
+        for (size_t i = begin; i < end; ++i) {
+            maxRadius = std::max(maxRadius, spheres[i].Radius);
+        }
+        partMaxRadius[part] = maxRadius;
+    });
+    m_maxRadius = count > 0 ? *std::max_element(partMaxRadius.begin(), partMaxRadius.end()) : 0.0f;
+
+    // Ячейка вмещает две самые крупные сферы с зазором typicalDistance: хватает соседних ячеек
+    m_cellSize = std::max(2.0f * m_maxRadius + std::max(typicalDistance, 0.0f), 1e-6f);
+
+    m_keys.resize(count);
+    m_sorted.resize(count);
+    parallelFor(m_pool, count, parts, [&](size_t begin, size_t end, unsigned part) {
+        for (size_t i = begin; i < end; ++i) {
+            m_keys[i] = bucketOf(cellOf(spheres[i].Center, m_cellSize));
+            m_sorted[i] = static_cast<uint32_t>(i);
+        }
+    });
+
+    // Устойчивая поразрядная сортировка пар (корзина, тело), младшие разряды первыми.
+    // Гистограмма части занимает 2^digitBits счётчиков, а не размер таблицы
+    int passes = (keyBits + SPATIAL_HASH_RADIX_BITS - 1) / SPATIAL_HASH_RADIX_BITS;
+    int digitBits = passes > 0 ? (keyBits + passes - 1) / passes : 0;
+    uint32_t radix = 1u << digitBits;
+    m_scratchKeys.resize(count);
+    m_scratchIndices.resize(count);
+    for (int pass = 0; pass < passes; ++pass) {
+        int shift = pass * digitBits;
+        m_digitCounts.assign(static_cast<size_t>(parts) * radix, 0u);
+        parallelFor(m_pool, count, parts, [&](size_t begin, size_t end, unsigned part) {
+            uint32_t* counts = m_digitCounts.data() + static_cast<size_t>(part) * radix;
+            for (size_t i = begin; i < end; ++i) {
+                ++counts[(m_keys[i] >> shift) & (radix - 1)];
+            }
+        });
+
+        // Внутри разряда части идут по порядку, поэтому порядок равных ключей сохраняется
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < radix; ++digit) {
+            for (unsigned part = 0; part < parts; ++part) {
+                uint32_t& slot = m_digitCounts[static_cast<size_t>(part) * radix + digit];
+                uint32_t digitCount = slot;
+                slot = offset;
+                offset += digitCount;
+            }
+        }
+
+        parallelFor(m_pool, count, parts, [&](size_t begin, size_t end, unsigned part) {
+            uint32_t* offsets = m_digitCounts.data() + static_cast<size_t>(part) * radix;
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t slot = offsets[(m_keys[i] >> shift) & (radix - 1)]++;
+                m_scratchKeys[slot] = m_keys[i];
+                m_scratchIndices[slot] = m_sorted[i];
+            }
+        });
+        m_keys.swap(m_scratchKeys);
+        m_sorted.swap(m_scratchIndices);
+    }
+
+    // Окно 3 x 3 x 3 ячеек можно просматривать строками, только если его корзины не совпадают
+    std::vector<uint32_t> window;
+    for (int y = 0; y < 3; ++y) {
+        for (int z = 0; z < 3; ++z) {
+            for (int x = 0; x < 3; ++x) {
+                window.push_back(bucketOf(glm::ivec3(x, y, z)));
+            }
+        }
+    }
+    std::sort(window.begin(), window.end());
+    m_compactNeighborhood = std::unique(window.begin(), window.end()) == window.end();
+
+    // Начала корзин: тело s открывает корзины после корзины предыдущего тела и до своей
+    m_cellStart.resize(static_cast<size_t>(tableSize) + 1);
+    m_sortedSpheres.resize(count);
+    parallelFor(m_pool, count, parts, [&](size_t begin, size_t end, unsigned part) {
+        for (size_t s = begin; s < end; ++s) {
+            uint32_t key = m_keys[s];
+            for (uint32_t b = s == 0 ? 0u : m_keys[s - 1] + 1; b <= key; ++b) {
+                m_cellStart[b] = static_cast<uint32_t>(s);
+            }
+            const BoundingSphere& sphere = spheres[m_sorted[s]];
+            m_sortedSpheres[s] = glm::vec4(sphere.Center, sphere.Radius);
+        }
+    });
+    size_t usedBuckets = count > 0 ? static_cast<size_t>(m_keys[count - 1]) + 1 : 0;
+    std::fill(m_cellStart.begin() + usedBuckets, m_cellStart.end(), static_cast<uint32_t>(count));
+}
+
+void SpatialHash::collectBuckets(const glm::vec3& center, float reach, std::vector<uint32_t>& buckets) const {
+    buckets.clear();
+    glm::ivec3 low = cellOf(center - glm::vec3(reach), m_cellSize);
+    glm::ivec3 high = cellOf(center + glm::vec3(reach), m_cellSize);
+
+    // При расстоянии намного больше ячейки проще пройти всю таблицу
+    double cells = static_cast<double>(high.x - low.x + 1) * (high.y - low.y + 1) * (high.z - low.z + 1);
+    if (cells >= static_cast<double>(m_mask) + 1.0) {
+        for (uint32_t b = 0; b <= m_mask; ++b) {
+            buckets.push_back(b);
+        }
+        return;
+    }
+
+    for (int x = low.x; x <= high.x; ++x) {
+        for (int y = low.y; y <= high.y; ++y) {
+            for (int z = low.z; z <= high.z; ++z) {
+                buckets.push_back(bucketOf(glm::ivec3(x, y, z)));
+            }
+        }
+    }
+    // Разные ячейки могут попасть в одну корзину: без повторов пары нашлись бы дважды
+    std::sort(buckets.begin(), buckets.end());
+    buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+}
+
+void SpatialHash::pairsCloserThan(float distance, std::vector<ProximityPair>& pairs, unsigned threadCount) const {
+    pairs.clear();
+    if (m_count < 2) {
+        return;
+    }
+
+    unsigned parts = chooseThreadCount(m_count, threadCount);
+    std::vector<std::vector<ProximityPair>> partPairs(parts);
+    parallelFor(m_pool, m_count, parts, [&](size_t begin, size_t end, unsigned part) {
+        std::vector<ProximityPair>& out = partPairs[part];
+        std::vector<uint32_t> buckets;
+        for (size_t s = begin; s < end; ++s) {
+            glm::vec4 a = m_sortedSpheres[s];
+            glm::vec3 center(a);
+            uint32_t i = m_sorted[s];
+
+            // Пара проверяется один раз - со стороны тела с меньшей позицией в m_sorted:
+            // до второго тела дотягиваются оба, потому что reach включает наибольший радиус
+            auto scan = [&](uint32_t first, uint32_t last) {
+                for (uint32_t t = std::max(first, static_cast<uint32_t>(s) + 1); t < last; ++t) {
+                    glm::vec4 other = m_sortedSpheres[t];
+                    float limit = distance + a.w + other.w;
+                    glm::vec3 d = glm::vec3(other) - center;
+                    float distanceSq = glm::dot(d, d);
+                    // Отбор по квадрату с запасом, окончательно - по зазору, как в bruteForcePairs
+                    if (limit <= 0.0f || distanceSq >= limit * limit * 1.001f)
+                        continue;
+                    float gap = std::sqrt(distanceSq) - a.w - other.w;
+                    if (gap < distance) {
+                        uint32_t j = m_sorted[t];
+                        ProximityPair pair;
+                        pair.A = std::min(i, j);
+                        pair.B = std::max(i, j);
+                        pair.Gap = gap;
+                        out.push_back(pair);
+                    }
+                }
+            };
+
+            float reach = distance + a.w + m_maxRadius;
+            glm::ivec3 low = cellOf(center - glm::vec3(reach), m_cellSize);
+            glm::ivec3 high = cellOf(center + glm::vec3(reach), m_cellSize);
+            int width = high.x - low.x + 1;
+            if (m_compactNeighborhood && width <= 3 && high.y - low.y < 3 && high.z - low.z < 3) {
+                // Корзины соседних по x ячеек идут подряд: строка ячеек - один диапазон m_sorted
+                for (int y = low.y; y <= high.y; ++y) {
+                    for (int z = low.z; z <= high.z; ++z) {
+                        uint32_t b = bucketOf(glm::ivec3(low.x, y, z));
+                        if (b + width - 1 <= m_mask) {
+                            scan(m_cellStart[b], m_cellStart[b + width]);
+                        }
+                        else {
+                            scan(m_cellStart[b], m_cellStart[m_mask + 1]);
+                            scan(m_cellStart[0], m_cellStart[b + width - 1 - m_mask]);
+                        }
+                    }
+                }
+                continue;
+            }
+
+            collectBuckets(center, reach, buckets);
+            for (uint32_t b : buckets) {
+                scan(m_cellStart[b], m_cellStart[b + 1]);
+            }
+        }
+    });
+
+    size_t total = 0;
+    for (const auto& part : partPairs) {
+        total += part.size();
+    }
+    pairs.reserve(total);
+    for (const auto& part : partPairs) {
+        pairs.insert(pairs.end(), part.begin(), part.end());
+    }
+}
+
+void SpatialHash::neighbors(size_t body, float distance, std::vector<ProximityPair>& result) const {
+    result.clear();
+    if (body >= m_count) {
+        return;
+    }
+
+    const BoundingSphere& sphere = m_spheres[body];
+    std::vector<uint32_t> buckets;
+    collectBuckets(sphere.Center, distance + sphere.Radius + m_maxRadius, buckets);
+    for (uint32_t b : buckets) {
+        for (uint32_t t = m_cellStart[b]; t < m_cellStart[b + 1]; ++t) {
+            uint32_t j = m_sorted[t];
+            if (j == body)
+                continue;
+            glm::vec4 other = m_sortedSpheres[t];
+            float gap = glm::length(glm::vec3(other) - sphere.Center) - sphere.Radius - other.w;
+            if (gap < distance) {
+                ProximityPair pair;
+                pair.A = static_cast<uint32_t>(body);
+                pair.B = j;
+                pair.Gap = gap;
+                result.push_back(pair);
+            }
+        }
+    }
+}
+
+void bruteForcePairs(const BoundingSphere* spheres, size_t count, float distance, std::vector<ProximityPair>& pairs) {
+    pairs.clear();
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = i + 1; j < count; ++j) {
+            float gap = glm::length(spheres[j].Center - spheres[i].Center) - spheres[i].Radius - spheres[j].Radius;
+            if (gap < distance) {
+                ProximityPair pair;
+                pair.A = static_cast<uint32_t>(i);
+                pair.B = static_cast<uint32_t>(j);
+                pair.Gap = gap;
+                pairs.push_back(pair);
+            }
+        }
+    }
+}
@@ -1,9 +1,23 @@
-#include "../headers/texture.h"
+﻿#include "../headers/texture.h"
+#include "../headers/resource_tracker.h"
+#include <algorithm>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h" 
 
-Texture::Texture(const char* path) : width(0), height(0), nrChannels(0), ID(0) {
+static int computeLevelCount(int w, int h) {
+    int levels = 1;
+    while (w > 1 || h > 1) {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+        ++levels;
+    }
+    return levels;
+}
+
+Texture::Texture(const char* path, bool streamed)
+    : ID(0), width(0), height(0), nrChannels(0), format(GL_RGB), path(path), streamed(streamed),
+    levelCount(0), tailLevel(0), residentBaseLevel(0) {
     glGenTextures(1, &ID);
     glBindTexture(GL_TEXTURE_2D, ID);
 
@@ -18,7 +32,6 @@ Texture::Texture(const char* path) : width(0), height(0), nrChannels(0), ID(0) {
     unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
 
     if (data) {
-        GLenum format = GL_RGB;
         if (nrChannels == 4)
             format = GL_RGBA;
         else if (nrChannels == 3)
@@ -29,9 +42,36 @@ Texture::Texture(const char* path) : width(0), height(0), nrChannels(0), ID(0) {
             std::cerr << "WARNING::TEXTURE::FORMAT: Unsupported number of channels (" << nrChannels << ") for: " << path << std::endl;
         }
 
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        levelCount = computeLevelCount(width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+        if (!streamed) {
+            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        else {
+            // Сразу загружается только хвост цепочки; детальные уровни подгружаются по требованию
+            while (tailLevel < levelCount - 1 && std::max(width >> tailLevel, height >> tailLevel) > STREAM_TAIL_SIZE) {
+                ++tailLevel;
+            }
+
+            std::vector<unsigned char> level(data, data + static_cast<size_t>(width) * height * nrChannels);
+            int w = width;
+            int h = height;
+            for (int l = 0; l < levelCount; ++l) {
+                if (l >= tailLevel)
+                    uploadLevel(l, level.data());
+                if (l + 1 < levelCount) {
+                    level = downsample(level.data(), w, h, nrChannels);
+                    w = w > 1 ? w / 2 : 1;
+                    h = h > 1 ? h / 2 : 1;
+                }
+            }
+            setResidentBaseLevel(tailLevel);
+        }
 
-        glGenerateMipmap(GL_TEXTURE_2D);
+        updateResidency();
     }
     else {
         std::cerr << "ERROR::TEXTURE::LOAD: Failed to load texture at path: " << path << std::endl;
@@ -43,6 +83,7 @@ Texture::Texture(const char* path) : width(0), height(0), nrChannels(0), ID(0) {
 }
 
 Texture::~Texture() {
+    ResourceTracker::instance().release(RESOURCE_GPU_TEXTURE, ID);
     glDeleteTextures(1, &ID);
 }
 
@@ -53,4 +94,101 @@ void Texture::bind(GLuint unit) {
 
 void Texture::unbind() {
     glBindTexture(GL_TEXTURE_2D, 0);
-}
\ No newline at end of file
+}
+
+void Texture::getLevelSize(int level, int& w, int& h) const {
+    w = std::max(width >> level, 1);
+    h = std::max(height >> level, 1);
+}
+
+size_t Texture::getLevelBytes(int level) const {
+    if (level < 0 || level >= levelCount)
+        return 0;
+
+    // Драйверы хранят RGB8 как RGBA8, поэтому трёхканальные текстуры считаются по 4 байта
+    size_t bytesPerPixel = nrChannels == 3 ? 4 : static_cast<size_t>(nrChannels);
+    int w, h;
+    getLevelSize(level, w, h);
+    return static_cast<size_t>(w) * h * bytesPerPixel;
+}
+
+size_t Texture::getMipChainBytes() const {
+    size_t total = 0;
+    for (int l = 0; l < levelCount; ++l) {
+        total += getLevelBytes(l);
+    }
+    return total;
+}
+
+size_t Texture::getResidentBytes() const {
+    size_t total = 0;
+    for (int l = residentBaseLevel; l < levelCount; ++l) {
+        total += getLevelBytes(l);
+    }
+    return total;
+}
+
+void Texture::uploadLevel(int level, const unsigned char* pixels) {
+    int w, h;
+    getLevelSize(level, w, h);
+
+    glBindTexture(GL_TEXTURE_2D, ID);
+    // Строки мелких уровней RGB не выровнены на 4 байта
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, level, format, w, h, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void Texture::setResidentBaseLevel(int level) {
+    residentBaseLevel = level;
+
+    glBindTexture(GL_TEXTURE_2D, ID);
+    // GL_TEXTURE_MIN_LOD отсчитывается от базового уровня, поэтому его не трогаем
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    updateResidency();
+}
+
+void Texture::evictLevelsBelow(int level) {
+    if (level <= residentBaseLevel)
+        return;
+
+    // Сначала поднимаем базовый уровень, чтобы текстура оставалась полной
+    int oldBase = residentBaseLevel;
+    setResidentBaseLevel(level);
+
+    // Переопределение уровня нулевого размера освобождает его память
+    glBindTexture(GL_TEXTURE_2D, ID);
+    for (int l = oldBase; l < level; ++l) {
+        glTexImage2D(GL_TEXTURE_2D, l, format, 0, 0, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::updateResidency() {
+    ResourceTracker::instance().setUsage(RESOURCE_GPU_TEXTURE, ID, getResidentBytes(), path);
+}
+
+std::vector<unsigned char> Texture::downsample(const unsigned char* pixels, int w, int h, int channels) {
+    int nw = w > 1 ? w / 2 : 1;
+    int nh = h > 1 ? h / 2 : 1;
+    std::vector<unsigned char> result(static_cast<size_t>(nw) * nh * channels);
+
+    for (int y = 0; y < nh; ++y) {
+        int y0 = std::min(y * 2, h - 1);
+        int y1 = std::min(y * 2 + 1, h - 1);
+        for (int x = 0; x < nw; ++x) {
+            int x0 = std::min(x * 2, w - 1);
+            int x1 = std::min(x * 2 + 1, w - 1);
+            for (int c = 0; c < channels; ++c) {
+                int sum = pixels[(static_cast<size_t>(y0) * w + x0) * channels + c]
+                    + pixels[(static_cast<size_t>(y0) * w + x1) * channels + c]
+                    + pixels[(static_cast<size_t>(y1) * w + x0) * channels + c]
+                    + pixels[(static_cast<size_t>(y1) * w + x1) * channels + c];
+                result[(static_cast<size_t>(y) * nw + x) * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
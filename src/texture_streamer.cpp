@@ -0,0 +1,230 @@
+﻿#include "../headers/texture_streamer.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+#include "stb_image.h"
+
+TextureStreamer::TextureStreamer(size_t vramBudget, size_t uploadBytesPerFrame)
+    : m_budget(vramBudget), m_uploadBytesPerFrame(uploadBytesPerFrame), m_stopping(false) {
+    m_worker = std::thread(&TextureStreamer::workerLoop, this);
+}
+
+TextureStreamer::~TextureStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_jobsChanged.notify_all();
+    m_worker.join();
+}
+
+void TextureStreamer::registerTexture(Texture* texture) {
+    if (texture == nullptr || !texture->isStreamed() || findEntry(texture) != nullptr) {
+        return;
+    }
+
+    Entry entry;
+    entry.texture = texture;
+    entry.coverage = 0.0f;
+    entry.requiredLevel = texture->getTailLevel();
+    entry.targetLevel = texture->getTailLevel();
+    entry.loadPending = false;
+    m_entries.push_back(entry);
+}
+
+TextureStreamer::Entry* TextureStreamer::findEntry(Texture* texture) {
+    for (Entry& entry : m_entries) {
+        if (entry.texture == texture)
+            return &entry;
+    }
+    return nullptr;
+}
+
+void TextureStreamer::requestCoverage(Texture* texture, float pixelSize) {
+    Entry* entry = findEntry(texture);
+    if (entry != nullptr) {
+        entry->coverage = std::max(entry->coverage, pixelSize);
+    }
+}
+
+void TextureStreamer::update() {
+    // Уровень, при котором один тексель приходится примерно на один пиксель
+    for (Entry& entry : m_entries) {
+        Texture* texture = entry.texture;
+        int tail = texture->getTailLevel();
+        if (entry.coverage <= 0.0f) {
+            entry.requiredLevel = tail;
+        }
+        else {
+            float texels = static_cast<float>(std::max(texture->getWidth(), texture->getHeight()));
+            int level = static_cast<int>(std::floor(std::log2(texels / entry.coverage)));
+            entry.requiredLevel = std::min(std::max(level, 0), tail);
+        }
+        entry.coverage = 0.0f;
+    }
+
+    applyBudget();
+
+    for (Entry& entry : m_entries) {
+        Texture* texture = entry.texture;
+        int base = texture->getResidentBaseLevel();
+
+        if (base < entry.targetLevel) {
+            texture->evictLevelsBelow(entry.targetLevel);
+        }
+        else if (base > entry.targetLevel && !entry.loadPending) {
+            LoadJob job;
+            job.texture = texture;
+            job.path = texture->getPath();
+            job.firstLevel = entry.targetLevel;
+            job.lastLevel = base;
+            entry.loadPending = true;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_jobs.push_back(job);
+            }
+            m_jobsChanged.notify_one();
+        }
+    }
+
+    applyResults();
+}
+
+void TextureStreamer::applyBudget() {
+    size_t total = 0;
+    for (Entry& entry : m_entries) {
+        entry.targetLevel = entry.requiredLevel;
+        for (int l = entry.targetLevel; l < entry.texture->getLevelCount(); ++l) {
+            total += entry.texture->getLevelBytes(l);
+        }
+    }
+
+    // Пока бюджет превышен, огрубляем текстуру с самым дорогим детальным уровнем
+    while (total > m_budget) {
+        Entry* worst = nullptr;
+        for (Entry& entry : m_entries) {
+            if (entry.targetLevel >= entry.texture->getTailLevel())
+                continue;
+            if (worst == nullptr || entry.texture->getLevelBytes(entry.targetLevel) > worst->texture->getLevelBytes(worst->targetLevel))
+                worst = &entry;
+        }
+        if (worst == nullptr)
+            break;
+        total -= worst->texture->getLevelBytes(worst->targetLevel);
+        ++worst->targetLevel;
+    }
+}
+
+void TextureStreamer::applyResults() {
+    size_t uploaded = 0;
+
+    while (true) {
+        LoadResult result;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_results.empty())
+                return;
+            // Ограничение объёма загрузки за кадр, но хотя бы один результат за кадр проходит
+            size_t bytes = 0;
+            for (const auto& level : m_results.front().levels) {
+                bytes += level.size();
+            }
+            if (uploaded > 0 && uploaded + bytes > m_uploadBytesPerFrame)
+                return;
+            uploaded += bytes;
+            result = std::move(m_results.front());
+            m_results.pop_front();
+        }
+
+        Entry* entry = findEntry(result.texture);
+        if (entry == nullptr)
+            continue;
+        entry->loadPending = false;
+
+        Texture* texture = result.texture;
+        int base = texture->getResidentBaseLevel();
+        int lastLevel = result.firstLevel + static_cast<int>(result.levels.size());
+        int newBase = std::max(result.firstLevel, entry->targetLevel);
+
+        // Пока шла загрузка, уровни могли быть освобождены: тогда в цепочке был бы разрыв
+        if (result.levels.empty() || newBase >= base || lastLevel < base)
+            continue;
+
+        for (int l = base - 1; l >= newBase; --l) {
+            texture->uploadLevel(l, result.levels[l - result.firstLevel].data());
+        }
+        texture->setResidentBaseLevel(newBase);
+    }
+}
+
+void TextureStreamer::workerLoop() {
+    while (true) {
+        LoadJob job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobsChanged.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping)
+                return;
+            job = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        LoadResult result;
+        result.texture = job.texture;
+        result.firstLevel = job.firstLevel;
+
+        int w, h, channels;
+        unsigned char* data = stbi_load(job.path.c_str(), &w, &h, &channels, 0);
+        if (data) {
+            // Та же цепочка уменьшений, что и при создании текстуры, чтобы уровни совпадали
+            std::vector<unsigned char> level(data, data + static_cast<size_t>(w) * h * channels);
+            stbi_image_free(data);
+
+            for (int l = 0; l < job.lastLevel; ++l) {
+                if (l >= job.firstLevel)
+                    result.levels.push_back(level);
+                if (l + 1 < job.lastLevel) {
+                    level = Texture::downsample(level.data(), w, h, channels);
+                    w = w > 1 ? w / 2 : 1;
+                    h = h > 1 ? h / 2 : 1;
+                }
+            }
+        }
+        else {
+            std::cerr << "ERROR::TEXTURE_STREAMER::LOAD: Failed to load texture at path: " << job.path << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_results.push_back(std::move(result));
+    }
+}
+
+size_t TextureStreamer::getResidentBytes() const {
+    size_t total = 0;
+    for (const Entry& entry : m_entries) {
+        total += entry.texture->getResidentBytes();
+    }
+    return total;
+}
+
+void TextureStreamer::report(std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::fixed << std::setprecision(2);
+    out << "--- Texture streaming: " << getResidentBytes() / (1024.0 * 1024.0) << " of "
+        << m_budget / (1024.0 * 1024.0) << " MiB resident ---" << std::endl;
+    for (const Entry& entry : m_entries) {
+        const Texture* texture = entry.texture;
+        int base = texture->getResidentBaseLevel();
+        out << "    " << texture->getPath() << " " << texture->getWidth() << "x" << texture->getHeight()
+            << ": resident from level " << base << " (" << std::max(texture->getWidth() >> base, 1) << "px)"
+            << ", required " << entry.requiredLevel << ", target " << entry.targetLevel
+            << ", " << texture->getResidentBytes() / (1024.0 * 1024.0) << " MiB"
+            << (entry.loadPending ? ", loading" : "") << std::endl;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,71 @@
+#include "../headers/view.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+View buildView(const glm::mat4& viewMatrix, const glm::vec3& position, float fovY,
+    const glm::vec4& rect, int windowWidth, int windowHeight) {
+    View view;
+
+    view.Rect = rect;
+    view.ViewportX = static_cast<int>(std::lround((rect.x - rect.z + 1.0f) * 0.5f * windowWidth));
+    view.ViewportY = static_cast<int>(std::lround((rect.y - rect.w + 1.0f) * 0.5f * windowHeight));
+    view.ViewportWidth = std::max(static_cast<int>(std::lround(rect.z * windowWidth)), 1);
+    view.ViewportHeight = std::max(static_cast<int>(std::lround(rect.w * windowHeight)), 1);
+
+    float aspect = static_cast<float>(view.ViewportWidth) / static_cast<float>(view.ViewportHeight);
+    view.ViewMatrix = viewMatrix;
+    view.Projection = glm::perspective(fovY, aspect, VIEW_NEAR_PLANE, VIEW_FAR_PLANE);
+    view.ViewProjection = view.Projection * view.ViewMatrix;
+    view.Position = position;
+    view.FocalPixels = 0.5f * view.ViewportHeight * view.Projection[1][1];
+    view.ViewFrustum = extractFrustum(view.ViewProjection);
+    return view;
+}
+
+Frustum extractFrustum(const glm::mat4& m) {
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.Planes[0] = row3 + row0;
+    frustum.Planes[1] = row3 - row0;
+    frustum.Planes[2] = row3 + row1;
+    frustum.Planes[3] = row3 - row1;
+    frustum.Planes[4] = row3 + row2;
+    frustum.Planes[5] = row3 - row2;
+    for (glm::vec4& plane : frustum.Planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+bool isSphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius) {
+    for (const glm::vec4& plane : frustum.Planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+float getProjectedSize(const View* views, int viewCount, const glm::vec3& center, float radius) {
+    float size = 0.0f;
+    for (int i = 0; i < viewCount; ++i) {
+        const View& view = views[i];
+        if (!isSphereInFrustum(view.ViewFrustum, center, radius))
+            continue;
+        float distance = std::max(glm::length(center - view.Position) - radius, VIEW_NEAR_PLANE);
+        size = std::max(size, 2.0f * radius * view.FocalPixels / distance);
+    }
+    return size;
+}
+
+glm::vec3 getRayDirection(const View& view, const glm::vec2& windowNdc) {
+    glm::vec2 ndc = (windowNdc - glm::vec2(view.Rect.x, view.Rect.y)) / glm::vec2(view.Rect.z, view.Rect.w);
+    glm::mat4 inverseViewProjection = glm::inverse(view.ViewProjection);
+    glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+    return glm::normalize(glm::vec3(farPoint) / farPoint.w - glm::vec3(nearPoint) / nearPoint.w);
+}
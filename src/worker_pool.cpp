@@ -0,0 +1,76 @@
+﻿#include "../headers/worker_pool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned threadCount)
+    : m_threadCount(threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u)),
+      m_work(nullptr), m_partCount(0), m_nextPart(0), m_pendingParts(0), m_stopping(false) {
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workReady.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::run(unsigned partCount, const std::function<void(unsigned)>& work) {
+    std::lock_guard<std::mutex> runLock(m_runMutex);
+    if (partCount <= 1 || m_threadCount <= 1) {
+        for (unsigned part = 0; part < partCount; ++part) {
+            work(part);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_workers.empty()) {
+        m_workers.reserve(m_threadCount - 1);
+        for (unsigned t = 1; t < m_threadCount; ++t) {
+            m_workers.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+
+    m_work = &work;
+    m_partCount = partCount;
+    m_nextPart = 0;
+    m_pendingParts = partCount;
+    m_workReady.notify_all();
+
+    while (runNextPart(lock)) {
+    }
+    m_workDone.wait(lock, [this] { return m_pendingParts == 0; });
+    m_work = nullptr;
+}
+
+bool WorkerPool::runNextPart(std::unique_lock<std::mutex>& lock) {
+    if (m_work == nullptr || m_nextPart >= m_partCount) {
+        return false;
+    }
+    unsigned part = m_nextPart++;
+    const std::function<void(unsigned)>* work = m_work;
+
+    lock.unlock();
+    (*work)(part);
+    lock.lock();
+
+    if (--m_pendingParts == 0) {
+        m_workDone.notify_all();
+    }
+    return true;
+}
+
+void WorkerPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_workReady.wait(lock, [this] { return m_stopping || (m_work != nullptr && m_nextPart < m_partCount); });
+        if (m_stopping) {
+            return;
+        }
+        while (runNextPart(lock)) {
+        }
+    }
+}